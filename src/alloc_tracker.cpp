@@ -0,0 +1,221 @@
+#include "alloc_tracker.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Growth of live bytes (compared to previous visit of the same scene) that is
+// considered a leak, rather than noise from lazy initialization.
+static constexpr std::int64_t LEAK_THRESHOLD = 4 * 1024;
+static constexpr std::size_t MAX_SCENES = 16;
+
+static std::atomic<std::uint64_t> total_allocs{0};
+static std::atomic<std::uint64_t> total_frees{0};
+static std::atomic<std::uint64_t> total_bytes{0};
+static std::atomic<std::int64_t> live_bytes{0};
+
+#if defined(GAME_TRACK_ALLOCATIONS)
+// Size of each allocation is stored right before returned pointer. Header is
+// max_align_t sized, so returned memory stays properly aligned.
+static constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+static void* tracked_alloc(std::size_t size) noexcept {
+    auto raw = static_cast<unsigned char*>(std::malloc(size + HEADER_SIZE));
+    if (raw == nullptr) {
+        return nullptr;
+    }
+
+    std::memcpy(raw, &size, sizeof(size));
+    total_allocs.fetch_add(1, std::memory_order_relaxed);
+    total_bytes.fetch_add(size, std::memory_order_relaxed);
+    live_bytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+
+    return raw + HEADER_SIZE;
+}
+
+static void tracked_free(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    auto raw = static_cast<unsigned char*>(ptr) - HEADER_SIZE;
+    std::size_t size;
+    std::memcpy(&size, raw, sizeof(size));
+    total_frees.fetch_add(1, std::memory_order_relaxed);
+    live_bytes.fetch_sub(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+
+    std::free(raw);
+}
+
+void* operator new(std::size_t size) {
+    void* ptr = tracked_alloc(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    void* ptr = tracked_alloc(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return tracked_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return tracked_alloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    tracked_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    tracked_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    tracked_free(ptr);
+}
+#endif
+
+struct SceneRecord {
+    const char* name = nullptr;
+    std::int64_t baseline = 0;
+    std::uint64_t visits = 0;
+    std::uint64_t allocs = 0;
+    std::uint64_t bytes = 0;
+    bool flagged = false;
+};
+
+struct TrackerState {
+    AllocCounters frame_start;
+    AllocCounters last_frame;
+
+    std::array<SceneRecord, MAX_SCENES> scenes;
+    std::size_t scenes_amount = 0;
+    SceneRecord* current_scene = nullptr;
+    AllocCounters scene_start;
+};
+
+static TrackerState state;
+
+AllocCounters AllocTracker::get_totals() {
+    AllocCounters c;
+    c.allocs = total_allocs.load(std::memory_order_relaxed);
+    c.frees = total_frees.load(std::memory_order_relaxed);
+    c.bytes = total_bytes.load(std::memory_order_relaxed);
+    c.live_bytes = live_bytes.load(std::memory_order_relaxed);
+    return c;
+}
+
+void AllocTracker::end_frame() {
+    const auto now = get_totals();
+    state.last_frame.allocs = now.allocs - state.frame_start.allocs;
+    state.last_frame.frees = now.frees - state.frame_start.frees;
+    state.last_frame.bytes = now.bytes - state.frame_start.bytes;
+    state.last_frame.live_bytes = now.live_bytes;
+    state.frame_start = now;
+}
+
+AllocCounters AllocTracker::get_last_frame() {
+    return state.last_frame;
+}
+
+static void close_scene(const AllocCounters& now) {
+    if (state.current_scene == nullptr) {
+        return;
+    }
+
+    state.current_scene->allocs += now.allocs - state.scene_start.allocs;
+    state.current_scene->bytes += now.bytes - state.scene_start.bytes;
+}
+
+void AllocTracker::on_scene_settled(const char* name) {
+    if (!is_enabled()) {
+        return;
+    }
+
+    const auto now = get_totals();
+    close_scene(now);
+
+    SceneRecord* record = nullptr;
+    for (std::size_t i = 0; i < state.scenes_amount; i++) {
+        if (std::strcmp(state.scenes[i].name, name) == 0) {
+            record = &state.scenes[i];
+            break;
+        }
+    }
+
+    if (record == nullptr) {
+        if (state.scenes_amount == MAX_SCENES) {
+            state.current_scene = nullptr;
+            return;
+        }
+        record = &state.scenes[state.scenes_amount++];
+        record->name = name;
+        record->baseline = now.live_bytes;
+    }
+    else if (now.live_bytes > record->baseline + LEAK_THRESHOLD) {
+        spdlog::warn(
+            "Live heap didn't return to baseline on entering {}: {} bytes above "
+            "previous visit",
+            name,
+            now.live_bytes - record->baseline);
+        record->flagged = true;
+        // Raise baseline, so the same growth isn't reported over and over
+        record->baseline = now.live_bytes;
+    }
+
+    record->visits++;
+    state.current_scene = record;
+    state.scene_start = now;
+}
+
+void AllocTracker::report() {
+    if (!is_enabled()) {
+        return;
+    }
+
+    const auto now = get_totals();
+    close_scene(now);
+    state.scene_start = now;
+
+    spdlog::info(
+        "Allocations total: {} allocs, {} frees, {} bytes, {} bytes still live",
+        now.allocs,
+        now.frees,
+        now.bytes,
+        now.live_bytes);
+    for (std::size_t i = 0; i < state.scenes_amount; i++) {
+        const auto& s = state.scenes[i];
+        spdlog::info(
+            "Scene {}: {} visits, {} allocs, {} bytes{}",
+            s.name,
+            s.visits,
+            s.allocs,
+            s.bytes,
+            s.flagged ? ", LEAKING" : "");
+    }
+}
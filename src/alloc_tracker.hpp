@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct AllocCounters {
+    std::uint64_t allocs = 0;
+    std::uint64_t frees = 0;
+    std::uint64_t bytes = 0;
+    std::int64_t live_bytes = 0;
+};
+
+// Counter of heap traffic that goes through global new/delete. Hooks are only
+// compiled in with GAME_TRACK_ALLOCATIONS, otherwise all counters stay at zero.
+// All functions but the counting itself must be called from main thread.
+class AllocTracker {
+public:
+    static constexpr bool is_enabled() {
+#if defined(GAME_TRACK_ALLOCATIONS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Counters since the start of program
+    static AllocCounters get_totals();
+
+    // Commit current frame. Must be called once per frame.
+    static void end_frame();
+    // Allocations done during last committed frame. live_bytes is absolute.
+    static AllocCounters get_last_frame();
+
+    // Must be called once scene has become current and previous one has been
+    // destroyed. If scene has been visited before and live bytes haven't
+    // returned to the level of that visit, scene gets flagged.
+    static void on_scene_settled(const char* name);
+
+    // Log per-scene allocation stats
+    static void report();
+};
@@ -1,6 +1,11 @@
 #include "app.hpp"
+#include "alloc_tracker.hpp"
+#include "common.hpp"
+#include "latency.hpp"
+#include "log.hpp"
 #include "platform.hpp"
-#include "menus.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
 
 #include <engine/utility.hpp>
 
@@ -8,30 +13,70 @@
 
 #include <fmt/format.h>
 
+#include <system_error>
+
+// Seconds between checks of settings file's modification time
+static constexpr float SETTINGS_CHECK_INTERVAL = 1.0f;
+
 App::App() {
+    TRACE_SCOPE("App::App");
 
     platform = Platform::make_platform();
 
     auto resource_dir = platform->get_resource_dir();
     auto settings_dir = platform->get_settings_dir();
 
+    settings_path = fmt::format("{}settings.toml", settings_dir);
     config = std::make_unique<SettingsManager>(
         toml::table{
             {"show_fps", true},
+            {"show_profiler", false},
             {"fullscreen", false},
             {"resolution", toml::array{1280, 720}},
             {"sfx_volume", 100},
-            {"music_volume", 100}},
-        fmt::format("{}settings.toml", settings_dir));
+            {"music_volume", 100},
+            // Runtime physics consistency checks: "off", "touched" or "full".
+            // Only effective if compiled in (see GAME_PHYSICS_CHECKS)
+            {"physics_checks", "touched"},
+            // Resolve clicks right before drawing, instead of in the middle of update
+            {"late_latch", false},
+            // Stop simulating balloons that are off screen and away from others
+            {"sim_lod", true},
+            // Vertical strips of the room, each with own physics world (stepped
+            // in parallel if built with GAME_PARALLEL_PHYSICS). 0 picks one per
+            // hardware thread.
+            {"physics_shards", 1},
+            // One of "vsync", "cap", "uncapped" or "adaptive"
+            {"frame_pacing", "vsync"},
+            // Frame rate limit for "cap" and "adaptive" pacing
+            {"fps_cap", 60},
+            // Lower frame rate in menus, pause and while window is unfocused
+            {"power_saving", true},
+            // Lower physics and visual quality if frames don't fit into budget
+            {"adaptive_quality", true},
+            // Physics, spawn, wind and log tunables, see PerformanceSettings
+            {"performance", make_performance_table(PerformanceSettings())}},
+        settings_path);
 
-    config->load();
+    {
+        TRACE_SCOPE("load settings");
+        config->load();
+    }
 
-    window.init(
-        std::max(config->settings["resolution"][0].value_or(1280), 1280),
-        std::max(config->settings["resolution"][1].value_or(720), 720),
-        "Balloon Buster");
+    std::error_code ec;
+    settings_mtime = std::filesystem::last_write_time(settings_path, ec);
+    apply_performance_settings();
+
+    {
+        TRACE_SCOPE("window init");
+        window.init(
+            std::max(config->settings["resolution"][0].value_or(1280), 1280),
+            std::max(config->settings["resolution"][1].value_or(720), 720),
+            "Balloon Buster");
+    }
 
     if (config->settings["fullscreen"].value_or(false) && !IsWindowFullscreen()) {
+        TRACE_SCOPE("toggle fullscreen");
         // TODO: add ability to specify active monitor
         const int current_screen = GetCurrentMonitor();
         // Its important to first toggle fullscreen and only them apply size.
@@ -40,15 +85,161 @@ App::App() {
         SetWindowSize(GetMonitorWidth(current_screen), GetMonitorHeight(current_screen));
     };
 
-    assets.sprites.load(platform->get_sprites_dir(), ".png");
-    assets.sounds.load(platform->get_sounds_dir(), ".ogg");
+    apply_frame_pacing();
+
+    {
+        TRACE_SCOPE("start job system");
+        jobs = std::make_unique<JobSystem>(JobSystem::get_default_workers());
+    }
+
+    governor = std::make_unique<IdleGovernor>(platform.get());
+    governor->set_enabled(config->settings["power_saving"].value_or(true));
+    quality.set_enabled(config->settings["adaptive_quality"].value_or(true));
+
+    {
+        TRACE_SCOPE("load sprites");
+        assets.sprites.load(platform->get_sprites_dir(), ".png");
+    }
+
+    {
+        TRACE_SCOPE("load sounds");
+        assets.sounds.load(platform->get_sounds_dir(), ".ogg");
+    }
+
+    {
+        TRACE_SCOPE("load sfx clips");
+        sfx.load_clip(
+            SfxClip::button_hover,
+            fmt::format("{}button_hover.ogg", platform->get_sounds_dir()),
+            4);
+        sfx.load_clip(
+            SfxClip::button_clicked,
+            fmt::format("{}button_clicked.ogg", platform->get_sounds_dir()),
+            4);
+
+        Wave pop_wave = make_pop_wave();
+        sfx.load_clip(SfxClip::balloon_pop, pop_wave, AudioMixer::MAX_VOICES);
+        UnloadWave(pop_wave);
+    }
+
+    sfx.set_volume(config->settings["sfx_volume"].value_or(100));
+
+    scenes = std::make_unique<SceneCache>(this, &window.sc_mgr);
+}
+
+AppNode::AppNode(App* app)
+    : app(app) {}
+
+void AppNode::update(float dt) {
+    app->update(dt);
+}
+
+void AppNode::draw() {
+    app->end_frame();
+}
+
+void App::update(float dt) {
+    InputLatency::get().begin_frame();
+    Profiler::get().end_frame(dt * 1000.0f);
+    AllocTracker::end_frame();
+    sfx.update();
+    jobs->run_main_thread_jobs();
+    jobs->end_frame();
+    check_settings_file(dt);
+    scenes->update();
+
+    governor->update(scenes->is_current_idle());
+    pacer.set_rate_limit(governor->get_fps_limit());
+}
+
+void App::end_frame() {
+    // Waiting before swap (and thus before input gets polled) means input is
+    // as fresh as possible when the next frame begins
+    pacer.wait();
+    InputLatency::get().end_frame();
+}
+
+void App::set_profiler_visible(bool visible) {
+    Profiler::get().set_enabled(visible);
+
+    auto& nodes = window.sc_mgr.nodes;
+    auto it = nodes.find("profiler");
+    if (visible && it == nodes.end()) {
+        nodes["profiler"] =
+            new ProfilerOverlay({4.0f, get_window_height() - 200.0f}, this);
+    }
+    else if (!visible && it != nodes.end()) {
+        delete it->second;
+        nodes.erase(it);
+    }
+}
+
+void App::apply_frame_pacing() {
+    pacer.set_mode(
+        parse_pacing_mode(config->settings["frame_pacing"].value_or(std::string("vsync"))),
+        config->settings["fps_cap"].value_or(60));
+}
+
+void App::apply_performance_settings() {
+    const auto new_perf = load_performance_settings(config->settings);
+    if (new_perf != perf) {
+        perf = new_perf;
+        perf_revision++;
+    }
+
+    set_log_level(spdlog::level::from_str(perf.log_level));
+    // Optional per-subsystem overrides, e.g log_levels = { physics = "trace" }
+    for (std::size_t i = 0; i < static_cast<std::size_t>(LogSubsystem::count); i++) {
+        const auto subsystem = static_cast<LogSubsystem>(i);
+        auto level = config->settings["log_levels"][get_logger_name(subsystem)]
+                         .value<std::string>();
+        if (!level) {
+            continue;
+        }
+        // from_str() returns "off" for anything it doesn't know
+        const auto parsed = spdlog::level::from_str(*level);
+        if (parsed == spdlog::level::off && *level != "off") {
+            spdlog::warn(
+                "log_levels.{} = \"{}\" is unknown, ignoring it",
+                get_logger_name(subsystem),
+                *level);
+            continue;
+        }
+        set_log_level(subsystem, parsed);
+    }
+}
+
+void App::check_settings_file(float dt) {
+    settings_check_left -= dt;
+    if (settings_check_left > 0.0f) {
+        return;
+    }
+    settings_check_left = SETTINGS_CHECK_INTERVAL;
+
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(settings_path, ec);
+    if (ec || mtime == settings_mtime) {
+        return;
+    }
+    settings_mtime = mtime;
+
+    spdlog::info("{} has changed, reloading performance settings", settings_path);
+    config->load();
+    apply_performance_settings();
 }
 
 void App::run() {
+    window.sc_mgr.nodes["app"] = new AppNode(this);
+    set_profiler_visible(config->settings["show_profiler"].value_or(false));
+
     if (config->settings["show_fps"].value_or(false)) {
         window.sc_mgr.nodes["fps_counter"] = new FrameCounter({4.0f, 4.0f});
     };
 
-    window.sc_mgr.set_current_scene(new TitleScreen(this, &window.sc_mgr));
+    scenes->open_title_screen();
     window.run();
+
+    pacer.report();
+    governor->report();
+    jobs->report();
 }
@@ -1,26 +1,83 @@
 #pragma once
 
+#include "audio.hpp"
+#include "frame_pacer.hpp"
+#include "idle.hpp"
+#include "jobs.hpp"
+#include "performance.hpp"
 #include "platform.hpp"
+#include "quality.hpp"
+#include "scene_cache.hpp"
 
 #include <engine/core.hpp>
 #include <engine/settings.hpp>
 #include <engine/storage.hpp>
 
+#include <filesystem>
 #include <memory>
+#include <string>
 
 struct AssetLoader {
     SpriteStorage sprites;
     SoundStorage sounds;
 };
 
+class App;
+
+// Node that has nothing to draw, but gets updated and drawn by SceneManager once
+// per frame. Used to run App's own per-frame routines.
+class AppNode : public Node {
+private:
+    App* app;
+
+public:
+    AppNode(App* app);
+
+    void update(float dt) override;
+    void draw() override;
+};
+
 class App {
 public:
     App();
 
     void run();
+    // Called once per frame by AppNode
+    void update(float dt);
+    // Called by AppNode once everything has been drawn
+    void end_frame();
+
+    // Toggle profiler together with its overlay
+    void set_profiler_visible(bool visible);
+    // Apply frame pacing settings from config
+    void apply_frame_pacing();
+    // Re-read [performance] table from config and apply log levels. Level
+    // applies the rest on its own, once perf_revision changes.
+    void apply_performance_settings();
 
     GameWindow window;
     AssetLoader assets;
+    AudioMixer sfx;
+    FramePacer pacer;
+    QualityGovernor quality;
     std::unique_ptr<SettingsManager> config;
+    PerformanceSettings perf;
+    // Incremented each time perf changes
+    unsigned perf_revision = 0;
     std::unique_ptr<Platform> platform;
+    // Must be declared after platform, since it uses it
+    std::unique_ptr<IdleGovernor> governor;
+    // Shared by everything that wants to use spare cores
+    std::unique_ptr<JobSystem> jobs;
+    // Declared last, so cached scenes are destroyed before anything they may use
+    std::unique_ptr<SceneCache> scenes;
+
+private:
+    // Settings file is re-read once it changes, so [performance] can be tuned
+    // while the game (and the level) is running
+    std::string settings_path;
+    std::filesystem::file_time_type settings_mtime;
+    float settings_check_left = 0.0f;
+
+    void check_settings_file(float dt);
 };
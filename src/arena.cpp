@@ -0,0 +1,97 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Pattern released memory is filled with in debug builds
+static constexpr unsigned char POISON = 0xCD;
+
+static std::uintptr_t align_up(std::uintptr_t value, std::size_t alignment) {
+    return (value + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+}
+
+LinearArena::LinearArena(std::size_t capacity)
+    : buffer(std::make_unique<std::byte[]>(capacity))
+    , capacity(capacity)
+    , offset(0)
+    , overflow_block_size(0)
+    , overflow_offset(0)
+    , used(0)
+    , high_water(0)
+    , overflows(0) {}
+
+void* LinearArena::allocate(std::size_t size, std::size_t alignment) {
+    const auto base = reinterpret_cast<std::uintptr_t>(buffer.get());
+    const auto aligned = align_up(base + offset, alignment);
+    const std::size_t new_offset = (aligned - base) + size;
+
+    if (new_offset > capacity) {
+        return allocate_overflow(size, alignment);
+    }
+
+    used += new_offset - offset;
+    offset = new_offset;
+    high_water = std::max(high_water, used);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void* LinearArena::allocate_overflow(std::size_t size, std::size_t alignment) {
+    if (!overflow_blocks.empty()) {
+        const auto base = reinterpret_cast<std::uintptr_t>(overflow_blocks.back().get());
+        const auto aligned = align_up(base + overflow_offset, alignment);
+        const std::size_t new_offset = (aligned - base) + size;
+
+        if (new_offset <= overflow_block_size) {
+            used += new_offset - overflow_offset;
+            overflow_offset = new_offset;
+            high_water = std::max(high_water, used);
+            return reinterpret_cast<void*>(aligned);
+        }
+    }
+
+    overflows++;
+    overflow_block_size = std::max(capacity, size + alignment);
+    overflow_blocks.push_back(std::make_unique<std::byte[]>(overflow_block_size));
+
+    const auto base = reinterpret_cast<std::uintptr_t>(overflow_blocks.back().get());
+    const auto aligned = align_up(base, alignment);
+    overflow_offset = (aligned - base) + size;
+    used += overflow_offset;
+    high_water = std::max(high_water, used);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void LinearArena::reset() {
+#if !defined(NDEBUG)
+    std::memset(buffer.get(), POISON, offset);
+#endif
+
+    if (!overflow_blocks.empty()) {
+        overflow_blocks.clear();
+        // Grow, so the same load fits without overflowing next time
+        capacity = std::max(capacity * 2, high_water);
+        buffer = std::make_unique<std::byte[]>(capacity);
+    }
+
+    offset = 0;
+    overflow_offset = 0;
+    overflow_block_size = 0;
+    used = 0;
+}
+
+std::size_t LinearArena::get_used() const {
+    return used;
+}
+
+std::size_t LinearArena::get_capacity() const {
+    return capacity;
+}
+
+std::size_t LinearArena::get_high_water() const {
+    return high_water;
+}
+
+std::size_t LinearArena::get_overflows() const {
+    return overflows;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator. Allocations are just pointer increments and are never freed
+// one by one - instead, everything is released at once, either on reset() or
+// when arena itself is destroyed. If arena runs out of space, additional blocks
+// are allocated from the heap (and counted as overflows). On next reset, main
+// buffer grows to fit everything, so overflows don't repeat every frame.
+class LinearArena {
+private:
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t capacity;
+    std::size_t offset;
+
+    std::vector<std::unique_ptr<std::byte[]>> overflow_blocks;
+    std::size_t overflow_block_size;
+    std::size_t overflow_offset;
+
+    // Bytes handed out since last reset, including padding
+    std::size_t used;
+    // The most bytes that have been used between two resets
+    std::size_t high_water;
+    std::size_t overflows;
+
+    void* allocate_overflow(std::size_t size, std::size_t alignment);
+
+public:
+    LinearArena(std::size_t capacity);
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    // Release everything at once. In debug builds, released memory gets filled
+    // with garbage, so dangling uses are easier to catch.
+    void reset();
+
+    std::size_t get_used() const;
+    std::size_t get_capacity() const;
+    std::size_t get_high_water() const;
+    std::size_t get_overflows() const;
+};
+
+// Standard allocator on top of LinearArena. Containers using it must not
+// outlive arena's reset.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    LinearArena* arena;
+
+    ArenaAllocator(LinearArena* arena) noexcept
+        : arena(arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : arena(other.arena) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Memory is released on arena's reset
+    void deallocate(T*, std::size_t) noexcept {}
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+    return a.arena != b.arena;
+}
+
+// Container for transient per-frame data
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,161 @@
+#include "audio.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+AudioMixer::~AudioMixer() {
+    for (auto& c : clips) {
+        unload_clip(c);
+    }
+}
+
+void AudioMixer::unload_clip(Clip& c) {
+    for (std::size_t i = 0; i < c.voices_amount; i++) {
+        UnloadSound(c.voices[i].sound);
+    }
+    c.voices_amount = 0;
+    c.next_voice = 0;
+}
+
+bool AudioMixer::load_clip(SfxClip clip, const std::string& path, std::size_t voices) {
+    Wave wave = LoadWave(path.c_str());
+    if (wave.data == nullptr) {
+        spdlog::warn("Unable to load sfx clip from {}", path);
+        return false;
+    }
+
+    load_clip(clip, wave, voices);
+    UnloadWave(wave);
+    return true;
+}
+
+void AudioMixer::load_clip(SfxClip clip, Wave wave, std::size_t voices) {
+    auto& c = clips[static_cast<std::size_t>(clip)];
+    unload_clip(c);
+
+    c.voices_amount = std::clamp<std::size_t>(voices, 1, MAX_VOICES);
+    for (std::size_t i = 0; i < c.voices_amount; i++) {
+        // Each voice has its own audio buffer, thus these can play simultaneously
+        c.voices[i].sound = LoadSoundFromWave(wave);
+        SetSoundVolume(c.voices[i].sound, volume);
+    }
+}
+
+void AudioMixer::play(SfxClip clip, SfxPriority priority) {
+    auto& c = clips[static_cast<std::size_t>(clip)];
+    if (c.voices_amount == 0) {
+        return;
+    }
+
+    if (c.last_frame == frame) {
+        stats.deduplicated++;
+        return;
+    }
+
+    Voice* target = nullptr;
+    bool stealing = false;
+    for (std::size_t i = 0; i < c.voices_amount; i++) {
+        auto& v = c.voices[i];
+        if (!IsSoundPlaying(v.sound)) {
+            target = &v;
+            stealing = false;
+            break;
+        }
+
+        if (v.priority > priority) {
+            continue;
+        }
+
+        if (target == nullptr || v.priority < target->priority ||
+            (v.priority == target->priority && v.started_at < target->started_at)) {
+            target = &v;
+            stealing = true;
+        }
+    }
+
+    if (target == nullptr) {
+        stats.dropped++;
+        return;
+    }
+
+    if (stealing) {
+        StopSound(target->sound);
+        stats.stolen++;
+    }
+
+    triggers++;
+    target->started_at = triggers;
+    target->priority = priority;
+    c.last_frame = frame;
+    PlaySound(target->sound);
+    stats.played++;
+}
+
+Sound* AudioMixer::get_voice(SfxClip clip) {
+    auto& c = clips[static_cast<std::size_t>(clip)];
+    if (c.voices_amount == 0) {
+        return nullptr;
+    }
+
+    Sound* voice = &c.voices[c.next_voice].sound;
+    c.next_voice = (c.next_voice + 1) % c.voices_amount;
+    return voice;
+}
+
+void AudioMixer::set_volume(int vol) {
+    volume = std::clamp(vol, 0, 100) / 100.0f;
+
+    for (auto& c : clips) {
+        for (std::size_t i = 0; i < c.voices_amount; i++) {
+            SetSoundVolume(c.voices[i].sound, volume);
+        }
+    }
+}
+
+void AudioMixer::update() {
+    frame++;
+}
+
+void AudioMixer::stop_all() {
+    for (auto& c : clips) {
+        for (std::size_t i = 0; i < c.voices_amount; i++) {
+            StopSound(c.voices[i].sound);
+        }
+    }
+}
+
+const AudioMixer::Stats& AudioMixer::get_stats() const {
+    return stats;
+}
+
+Wave make_pop_wave() {
+    const unsigned int sample_rate = 22050;
+    const unsigned int frames = sample_rate / 12;
+
+    auto samples = static_cast<short*>(std::malloc(frames * sizeof(short)));
+
+    // Simple LCG, so the sound is the same on every launch
+    unsigned int seed = 0x1234567u;
+    for (unsigned int i = 0; i < frames; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = static_cast<float>(seed >> 16) / 32768.0f - 1.0f;
+        const float t = static_cast<float>(i) / sample_rate;
+        const float thump = std::sin(2.0f * PI * 180.0f * t);
+        const float envelope = std::exp(-t * 60.0f);
+
+        samples[i] =
+            static_cast<short>((noise * 0.7f + thump * 0.3f) * envelope * 32767.0f * 0.8f);
+    }
+
+    Wave wave;
+    wave.frameCount = frames;
+    wave.sampleRate = sample_rate;
+    wave.sampleSize = 16;
+    wave.channels = 1;
+    wave.data = samples;
+
+    return wave;
+}
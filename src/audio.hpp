@@ -0,0 +1,99 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Clips known to mixer. These are enum values instead of strings, so triggering
+// sound is an array lookup without any hashing or allocations.
+enum class SfxClip : std::uint8_t {
+    button_hover,
+    button_clicked,
+    balloon_pop,
+    count
+};
+
+// When all voices of clip are busy, new sound will steal the voice with lowest
+// priority (and the oldest one among these). Voices with higher priority than
+// requested are never stolen.
+enum class SfxPriority : std::uint8_t {
+    low,
+    normal,
+    high
+};
+
+// Fixed pool of sound aliases per clip. All voices are created on load, thus
+// playback itself never allocates and costs the same regardless of how many
+// sounds have been requested during the frame.
+class AudioMixer {
+public:
+    static constexpr std::size_t MAX_VOICES = 8;
+
+    struct Stats {
+        std::size_t played = 0;
+        std::size_t stolen = 0;
+        std::size_t dropped = 0;
+        std::size_t deduplicated = 0;
+    };
+
+    AudioMixer() = default;
+    AudioMixer(const AudioMixer&) = delete;
+    AudioMixer& operator=(const AudioMixer&) = delete;
+    ~AudioMixer();
+
+    // Load clip from wave file and create specified amount of voices for it.
+    // Returns false if file could not be loaded.
+    bool load_clip(SfxClip clip, const std::string& path, std::size_t voices);
+    // Same as above, but from already loaded wave. Wave is not unloaded.
+    void load_clip(SfxClip clip, Wave wave, std::size_t voices);
+
+    // Request clip to be played. Identical requests within the same frame are
+    // merged into one.
+    void play(SfxClip clip, SfxPriority priority = SfxPriority::normal);
+
+    // Returns voices in round-robin manner. Meant for widgets that play sounds
+    // by themselves (e.g Button), so these don't cut each other's playback.
+    Sound* get_voice(SfxClip clip);
+
+    // Volume is in 0-100 range, same as sfx_volume setting.
+    void set_volume(int volume);
+
+    // Must be called once per frame.
+    void update();
+
+    void stop_all();
+
+    const Stats& get_stats() const;
+
+private:
+    struct Voice {
+        Sound sound;
+        // Trigger number this voice has been started with. Used to find the
+        // oldest voice to steal.
+        std::uint64_t started_at = 0;
+        SfxPriority priority = SfxPriority::low;
+    };
+
+    struct Clip {
+        std::array<Voice, MAX_VOICES> voices;
+        std::size_t voices_amount = 0;
+        std::size_t next_voice = 0;
+        std::uint64_t last_frame = 0;
+    };
+
+    std::array<Clip, static_cast<std::size_t>(SfxClip::count)> clips;
+    // Starts from 1, so clips that have never been played aren't deduplicated.
+    std::uint64_t frame = 1;
+    std::uint64_t triggers = 0;
+    float volume = 1.0f;
+    Stats stats;
+
+    void unload_clip(Clip& c);
+};
+
+// Generate short burst of decaying noise, used as balloon pop sound.
+// Returned wave owns its data and must be freed with UnloadWave().
+Wave make_pop_wave();
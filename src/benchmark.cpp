@@ -0,0 +1,209 @@
+#include "benchmark.hpp"
+
+#include "alloc_tracker.hpp"
+#include "app.hpp"
+#include "common.hpp"
+#include "level.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+static constexpr int BALLOONS_AMOUNTS[] = {500, 2000, 8000};
+static constexpr int FRAMES = 60;
+static constexpr float FRAME_TIME = 1.0f / 60.0f;
+// Particles live for at least 0.4 s, thus none die while these are measured
+static constexpr int PARTICLE_FRAMES = 15;
+// Passes over all balloons, for comparing group and view iteration
+static constexpr int ITERATION_PASSES = 100;
+// Radius of explosions in chain reaction scenario, large enough to pop the
+// whole crowd in a few waves
+static constexpr float CHAIN_RADIUS = 100.0f;
+// Gives up on chain reaction that hasn't ended by then
+static constexpr int MAX_CHAIN_FRAMES = 10000;
+// Room for sharded physics, in window widths
+static constexpr float SHARDED_ROOM_WIDTH = 16.0f;
+static constexpr int SHARDED_BALLOONS = 32000;
+
+using BenchClock = std::chrono::steady_clock;
+
+static float elapsed_ms(BenchClock::time_point start, BenchClock::time_point end) {
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+Benchmark::Benchmark(App* app)
+    : app(app) {}
+
+void Benchmark::run_level(int balloons) {
+    const auto build_start = BenchClock::now();
+    auto level = std::make_unique<Level>(app);
+    level->spawn_balls(balloons);
+    const auto build_end = BenchClock::now();
+
+    const auto allocs_before = AllocTracker::get_totals();
+    for (int i = 0; i < FRAMES; i++) {
+        level->update(FRAME_TIME);
+    }
+    const auto update_end = BenchClock::now();
+    const auto allocs_after = AllocTracker::get_totals();
+
+    // Splash covering the whole room, i.e the worst case for area queries
+    const b2Vec2 room_center = {level->room_size.x / 2.0f, level->room_size.y / 2.0f};
+    const float room_radius = std::max(level->room_size.x, level->room_size.y);
+    std::size_t hits = 0;
+    for (int i = 0; i < FRAMES; i++) {
+        hits = level->hit_tester.query_radius(room_center, room_radius).size();
+    }
+    const auto query_end = BenchClock::now();
+
+    // Same components, walked through the owning group and through a view,
+    // which probes sparse sets of all but the smallest pool. Bodies aren't
+    // touched, so only the iteration itself is measured.
+    float checksum = 0.0f;
+    const auto sum = [&checksum](auto, auto& ball, auto&, auto& color, auto& hp) {
+        checksum += ball.radius * static_cast<float>(hp.health + color.color.a);
+    };
+    auto view = level->registry.view<
+        BallComponent,
+        PhysicsBodyComponent,
+        ColorComponent,
+        HealthComponent>();
+    // Untimed pass of each, then passes alternate their order, so neither of
+    // these gets caches warmed up by the other one
+    level->balls.each(sum);
+    view.each(sum);
+    float group_ms = 0.0f;
+    float view_ms = 0.0f;
+    for (int i = 0; i < ITERATION_PASSES; i++) {
+        const bool group_first = i % 2 == 0;
+        for (int j = 0; j < 2; j++) {
+            const bool is_group = (j == 0) == group_first;
+            const auto pass_start = BenchClock::now();
+            if (is_group) {
+                level->balls.each(sum);
+            }
+            else {
+                view.each(sum);
+            }
+            (is_group ? group_ms : view_ms) += elapsed_ms(pass_start, BenchClock::now());
+        }
+    }
+
+    // Every balloon popping at once, clamped by pool's hard cap
+    for (int i = 0; i < balloons; i++) {
+        level->particles.emit_pop({room_center.x, room_center.y}, 30.0f, BLUE);
+    }
+    const auto particles = level->particles.get_stats();
+    const auto particles_start = BenchClock::now();
+    for (int i = 0; i < PARTICLE_FRAMES; i++) {
+        level->particles.update(FRAME_TIME, *app->jobs);
+    }
+    const auto particles_end = BenchClock::now();
+
+    // Every balloon is explosive and one of them pops. Cascade must be spread
+    // over frames, so the worst one stays cheap regardless of crowd's size.
+    for (auto entity : level->balls) {
+        level->registry.emplace_or_replace<ExplosiveComponent>(entity, CHAIN_RADIUS);
+    }
+    const int killed_before = level->enemies_killed;
+    level->events.push(BalloonHit{*level->balls.begin(), 1});
+    float chain_worst_ms = 0.0f;
+    int chain_frames = 0;
+    while (chain_frames < MAX_CHAIN_FRAMES
+           && (level->chain.get_pending() > 0 || !level->events.empty())) {
+        const auto frame_start = BenchClock::now();
+        level->chain.update(level->hit_tester, level->events);
+        level->process_events();
+        chain_worst_ms =
+            std::max(chain_worst_ms, elapsed_ms(frame_start, BenchClock::now()));
+        chain_frames++;
+    }
+    const int chain_popped = level->enemies_killed - killed_before;
+    const auto chain_end = BenchClock::now();
+
+    level.reset();
+    const auto teardown_end = BenchClock::now();
+
+    const float query_ms = elapsed_ms(update_end, query_end) / FRAMES;
+    spdlog::info(
+        "{:>6} balloons: build {:8.2f} ms, update {:7.3f} ms/frame, teardown {:7.3f} ms",
+        balloons,
+        elapsed_ms(build_start, build_end),
+        elapsed_ms(build_end, update_end) / FRAMES,
+        elapsed_ms(chain_end, teardown_end));
+    spdlog::info(
+        "{:>6} balloons: radius query {:7.3f} ms ({} hits)", balloons, query_ms, hits);
+    spdlog::info(
+        "{:>6} balloons: iteration via group {:7.4f} ms, via view {:7.4f} ms ({})",
+        balloons,
+        group_ms / ITERATION_PASSES,
+        view_ms / ITERATION_PASSES,
+        checksum);
+    spdlog::info(
+        "{:>6} balloons: chain reaction popped {} in {} frames, worst frame {:7.3f} ms",
+        balloons,
+        chain_popped,
+        chain_frames,
+        chain_worst_ms);
+    spdlog::info(
+        "{:>6} balloons: particles update {:7.3f} ms ({} alive, {} dropped)",
+        balloons,
+        elapsed_ms(particles_start, particles_end) / PARTICLE_FRAMES,
+        particles.alive,
+        particles.dropped);
+
+    if (AllocTracker::is_enabled()) {
+        spdlog::info(
+            "{:>6} balloons: {} allocs/frame, {} bytes/frame during update",
+            balloons,
+            (allocs_after.allocs - allocs_before.allocs) / FRAMES,
+            (allocs_after.bytes - allocs_before.bytes) / FRAMES);
+    }
+}
+
+void Benchmark::run_sharded(int shards) {
+    // Level picks it up on construction
+    app->config->settings.insert_or_assign("physics_shards", shards);
+    const Vector2 room_size = {
+        static_cast<float>(get_window_width()) * SHARDED_ROOM_WIDTH,
+        static_cast<float>(get_window_height())};
+    auto level = std::make_unique<Level>(app, room_size);
+    level->spawn_balls(SHARDED_BALLOONS);
+
+    const auto update_start = BenchClock::now();
+    for (int i = 0; i < FRAMES; i++) {
+        level->update(FRAME_TIME);
+    }
+    const auto update_end = BenchClock::now();
+
+    spdlog::info(
+        "{:>6} balloons, {} shards: update {:7.3f} ms/frame, {} migrations, {} ghosts",
+        SHARDED_BALLOONS,
+        level->shards.get_amount(),
+        elapsed_ms(update_start, update_end) / FRAMES,
+        level->shards.get_migrations(),
+        level->shards.get_ghost_count());
+}
+
+void Benchmark::run() {
+    spdlog::info("Running benchmarks");
+
+    // Results must be comparable between runs, regardless of how fast they are
+    const bool adaptive_quality = app->quality.is_enabled();
+    app->quality.set_enabled(false);
+
+    for (int amount : BALLOONS_AMOUNTS) {
+        run_level(amount);
+    }
+
+    // Step throughput of a single world versus one per core
+    const int shards = app->config->settings["physics_shards"].value_or(1);
+    run_sharded(1);
+    run_sharded(0);
+    app->config->settings.insert_or_assign("physics_shards", shards);
+
+    AllocTracker::report();
+    app->quality.set_enabled(adaptive_quality);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+class App;
+
+// Stress scenarios, run instead of the game with --benchmark. Builds levels
+// with lots of balloons, steps them for a while and tears them down, logging
+// how long each stage took.
+class Benchmark {
+private:
+    App* app;
+
+    void run_level(int balloons);
+    // Wide room, with physics split into that many shards (0 - one per core)
+    void run_sharded(int shards);
+
+public:
+    Benchmark(App* app);
+
+    void run();
+};
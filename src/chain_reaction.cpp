@@ -0,0 +1,73 @@
+#include "chain_reaction.hpp"
+
+#include "log.hpp"
+
+#include <algorithm>
+
+// Enough for a few explosions in a dense crowd without reallocations
+static constexpr std::size_t CAUGHT_RESERVE = 256;
+
+ChainReaction::ChainReaction(std::size_t budget)
+    : budget(std::max<std::size_t>(budget, 1))
+    , stats() {
+    caught.reserve(CAUGHT_RESERVE);
+}
+
+void ChainReaction::push(const Explosion& explosion) {
+    pending.push_back(explosion);
+    stats.peak_pending = std::max(stats.peak_pending, pending.size());
+}
+
+void ChainReaction::update(HitTester& hit_tester, GameplayEvents& events) {
+    if (pending.empty()) {
+        return;
+    }
+
+    caught.clear();
+
+    const std::size_t amount = std::min(budget, pending.size());
+    for (std::size_t i = 0; i < amount; i++) {
+        const Explosion explosion = pending.front();
+        pending.pop_front();
+
+        for (auto entity : hit_tester.query_radius(explosion.center, explosion.radius)) {
+            caught.push_back({entity, explosion.damage});
+        }
+    }
+    stats.detonated += amount;
+    if (!pending.empty()) {
+        stats.deferred_frames++;
+    }
+
+    // Neighbouring explosions mostly catch the same balloons. Each one is hit
+    // once, by the strongest of these.
+    std::sort(caught.begin(), caught.end(), [](const BalloonHit& a, const BalloonHit& b) {
+        if (a.entity != b.entity) {
+            return a.entity < b.entity;
+        }
+        return a.damage > b.damage;
+    });
+    const auto last = std::unique(
+        caught.begin(), caught.end(), [](const BalloonHit& a, const BalloonHit& b) {
+            return a.entity == b.entity;
+        });
+
+    for (auto it = caught.begin(); it != last; ++it) {
+        events.push(*it);
+    }
+
+    LOG_TRACE(
+        game,
+        "Detonated {} explosions, caught {} balloons, {} explosions pending",
+        amount,
+        static_cast<std::size_t>(last - caught.begin()),
+        pending.size());
+}
+
+std::size_t ChainReaction::get_pending() const {
+    return pending.size();
+}
+
+const ChainReaction::Stats& ChainReaction::get_stats() const {
+    return stats;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "events.hpp"
+#include "hit_test.hpp"
+
+#include <box2d/b2_math.h>
+#include <entt/entity/registry.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// Explosions of popped explosive balloons, which may pop more explosive
+// balloons, and so on. Explosions are queued and detonated breadth first, at
+// most budget of them per frame - the rest waits for the next frames. Thus a
+// cascade through a dense crowd spreads over time, instead of resolving all at
+// once in a single very long frame.
+//
+// Each detonation is a single broadphase query. Balloons caught by several
+// explosions of the same frame are hit once, and explosive balloons explode
+// once (when popped), so total work is linear in amount of balloons involved.
+class ChainReaction {
+public:
+    struct Explosion {
+        b2Vec2 center;
+        float radius;
+        int damage;
+    };
+
+    struct Stats {
+        std::size_t detonated;
+        // The most explosions that have been waiting at once
+        std::size_t peak_pending;
+        // Frames that have left some explosions for later
+        std::size_t deferred_frames;
+    };
+
+    // Budget is amount of explosions per frame
+    ChainReaction(std::size_t budget);
+
+    ChainReaction(const ChainReaction&) = delete;
+    ChainReaction& operator=(const ChainReaction&) = delete;
+
+    void push(const Explosion& explosion);
+    // Detonate up to budget of queued explosions, pushing hits for caught
+    // balloons into events. Dormant balloons aren't in broadphase, thus can't
+    // be caught.
+    void update(HitTester& hit_tester, GameplayEvents& events);
+
+    std::size_t get_pending() const;
+    const Stats& get_stats() const;
+
+private:
+    std::size_t budget;
+    std::deque<Explosion> pending;
+    // Hits of the current update, reused between frames
+    std::vector<BalloonHit> caught;
+    Stats stats;
+};
@@ -7,6 +7,16 @@
 GuiBuilder::GuiBuilder(App* app)
     : app(app) {}
 
+Sound* GuiBuilder::get_sound(SfxClip clip, const std::string& fallback) {
+    // Prefer mixer's voices, so rapid hovers over different buttons don't cut
+    // each other. Fallback to storage if clip could not be loaded into mixer.
+    Sound* voice = app->sfx.get_voice(clip);
+    if (voice == nullptr) {
+        return app->assets.sounds[fallback];
+    }
+    return voice;
+}
+
 Button* GuiBuilder::make_close_button() {
     return new Button(
         {
@@ -17,8 +27,8 @@ Button* GuiBuilder::make_close_button() {
             {ButtonStates::disabled, app->assets.sprites["cross_default"]}
         },
         {
-            {ButtonStates::hover, app->assets.sounds["button_hover"]},
-            {ButtonStates::clicked, app->assets.sounds["button_clicked"]}
+            {ButtonStates::hover, get_sound(SfxClip::button_hover, "button_hover")},
+            {ButtonStates::clicked, get_sound(SfxClip::button_clicked, "button_clicked")}
         },
         Rectangle{0, 0, 64, 64});
 }
@@ -34,8 +44,8 @@ Button* GuiBuilder::make_text_button(std::string txt) {
             {ButtonStates::disabled, app->assets.sprites["button_default"]}
         },
         {
-            {ButtonStates::hover, app->assets.sounds["button_hover"]},
-            {ButtonStates::clicked, app->assets.sounds["button_clicked"]}
+            {ButtonStates::hover, get_sound(SfxClip::button_hover, "button_hover")},
+            {ButtonStates::clicked, get_sound(SfxClip::button_clicked, "button_clicked")}
         },
         Rectangle{0, 0, 256, 64});
 }
@@ -57,8 +67,8 @@ Checkbox* GuiBuilder::make_checkbox(bool default_state) {
             {ButtonStates::disabled, app->assets.sprites["toggle_off_default"]}
         },
         {
-            {ButtonStates::hover, app->assets.sounds["button_hover"]},
-            {ButtonStates::clicked, app->assets.sounds["button_clicked"]}
+            {ButtonStates::hover, get_sound(SfxClip::button_hover, "button_hover")},
+            {ButtonStates::clicked, get_sound(SfxClip::button_clicked, "button_clicked")}
         },
         Rectangle{0, 0, 32, 32},
         default_state);
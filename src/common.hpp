@@ -1,3 +1,5 @@
+#include "audio.hpp"
+
 #include <raylib.h>
 
 #include <string>
@@ -21,6 +23,8 @@ public:
 
 private:
     App* app;
+
+    Sound* get_sound(SfxClip clip, const std::string& fallback);
 };
 
 // Returns random Vector2 with values between 0 and provided
@@ -2,6 +2,3 @@
 
 ColorComponent::ColorComponent(const Color& color)
     : color(color) {}
-
-PhysicsBodyComponent::PhysicsBodyComponent()
-    : user_data(std::make_unique<FixtureUserData>()) {}
@@ -5,12 +5,25 @@
 #include <entt/entt.hpp>
 #include <raylib.h>
 
-// Our components.
+#include <cstdint>
+#include <type_traits>
 
-struct FixtureUserData {
-    entt::entity entity;
-    const entt::registry* registry;
-};
+// Physics bodies and their fixtures store id of entity they belong to right in
+// their user data. This way there is nothing to allocate per body, and nothing
+// to dereference when going from fixture to entity during queries.
+inline uintptr_t to_user_data(entt::entity entity) {
+    return static_cast<uintptr_t>(entt::to_integral(entity));
+}
+
+inline entt::entity get_entity(b2Fixture* fixture) {
+    return static_cast<entt::entity>(fixture->GetUserData().pointer);
+}
+
+inline entt::entity get_entity(b2Body* body) {
+    return static_cast<entt::entity>(body->GetUserData().pointer);
+}
+
+// Our components.
 
 struct RectangleComponent {
     Vector2 half_size;
@@ -21,11 +34,11 @@ struct BallComponent {
     float radius;
 };
 
+// Trivially copyable, thus entt can pack and relocate these freely
 struct PhysicsBodyComponent {
-    std::unique_ptr<FixtureUserData> user_data;
-    b2Body* body;
-    PhysicsBodyComponent();
+    b2Body* body = nullptr;
 };
+static_assert(std::is_trivially_copyable_v<PhysicsBodyComponent>);
 
 struct ColorComponent {
     Color color;
@@ -35,3 +48,11 @@ struct ColorComponent {
 struct HealthComponent {
     int health;
 };
+
+// Balloon that damages everything around once popped
+struct ExplosiveComponent {
+    float radius;
+};
+
+// Balloon whose body is disabled and moved by SimulationLod instead of box2d
+struct DormantComponent {};
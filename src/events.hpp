@@ -0,0 +1,95 @@
+#pragma once
+
+#include <box2d/b2_math.h>
+#include <entt/entity/registry.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+// Gameplay events. Producers (input, physics, wind) only describe what happened,
+// while consumers (scoring, HUD, audio, effects) apply it once per frame.
+
+// Balloon has been hit, but not necessarily popped
+struct BalloonHit {
+    entt::entity entity;
+    int damage;
+};
+
+// Balloon's health has dropped to zero. Entity is still alive till the end of
+// events processing, so its components can be inspected.
+struct BalloonPopped {
+    entt::entity entity;
+    b2Vec2 position;
+    float radius;
+};
+
+// Balloon has flown out of the top of the screen
+struct BalloonEscaped {
+    entt::entity entity;
+};
+
+struct PlayerDamaged {
+    int damage;
+};
+
+struct WindGust {
+    b2Vec2 velocity;
+    // Bodies affected by it
+    int bodies;
+};
+
+// Per-type queues of events that happened during current frame. Storage is
+// reserved upfront and is kept between frames, so pushing events doesn't
+// allocate in steady state. If some queue runs out of space, it grows (and
+// this gets counted as overflow) - events are never dropped, since scoring
+// depends on each one of them.
+template <typename... Events>
+class EventQueue {
+private:
+    std::tuple<std::vector<Events>...> queues;
+    std::size_t overflows;
+
+    template <typename T>
+    std::vector<T>& get_queue() {
+        return std::get<std::vector<T>>(queues);
+    }
+
+public:
+    EventQueue(std::size_t capacity)
+        : queues()
+        , overflows(0) {
+        (get_queue<Events>().reserve(capacity), ...);
+    }
+
+    template <typename T>
+    void push(const T& event) {
+        auto& queue = get_queue<T>();
+        if (queue.size() == queue.capacity()) {
+            overflows++;
+        }
+        queue.push_back(event);
+    }
+
+    // Events of type T, in order they have been pushed
+    template <typename T>
+    const std::vector<T>& get() const {
+        return std::get<std::vector<T>>(queues);
+    }
+
+    bool empty() const {
+        return (get<Events>().empty() && ...);
+    }
+
+    // Drop all events, but keep storage
+    void clear() {
+        (get_queue<Events>().clear(), ...);
+    }
+
+    std::size_t get_overflows() const {
+        return overflows;
+    }
+};
+
+using GameplayEvents =
+    EventQueue<BalloonHit, BalloonPopped, BalloonEscaped, PlayerDamaged, WindGust>;
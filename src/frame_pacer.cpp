@@ -0,0 +1,241 @@
+#include "frame_pacer.hpp"
+
+#include <raylib.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+static constexpr const char* MODE_NAMES[static_cast<std::size_t>(PacingMode::count)] = {
+    "vsync",
+    "cap",
+    "uncapped",
+    "adaptive",
+};
+
+// Bounds of time that is spun through at the end of wait. Spinning longer than
+// that would burn most of the core at high frame rates - it's better to be late
+// once in a while. Systems with coarse timers get 1 ms resolution requested by
+// platform instead (see PlatformWindows).
+static constexpr float MIN_SPIN_MS = 0.2f;
+static constexpr float MAX_SPIN_MS = 2.0f;
+static constexpr float INITIAL_SPIN_MS = 1.0f;
+// A single late sleep may only grow spin that much
+static constexpr float MAX_SPIN_GROWTH_MS = 0.5f;
+// Spin shrinks on every wait it hasn't been needed for
+static constexpr float SPIN_DECAY = 0.9f;
+
+// Adaptive mode is re-evaluated once per that many frames
+static constexpr int ADAPT_WINDOW = 60;
+static constexpr int MAX_DIVISOR = 4;
+// Rate is lowered if average work exceeds this part of budget, and raised back
+// once it fits into that part of higher rate's budget
+static constexpr float ADAPT_DOWN = 0.95f;
+static constexpr float ADAPT_UP = 0.75f;
+
+static float to_ms(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+PacingMode parse_pacing_mode(const std::string& name) {
+    for (std::size_t i = 0; i < static_cast<std::size_t>(PacingMode::count); i++) {
+        if (name == MODE_NAMES[i]) {
+            return static_cast<PacingMode>(i);
+        }
+    }
+
+    spdlog::warn("Unknown frame pacing mode \"{}\", using vsync", name);
+    return PacingMode::vsync;
+}
+
+const char* get_pacing_mode_name(PacingMode mode) {
+    return MODE_NAMES[static_cast<std::size_t>(mode)];
+}
+
+FramePacer::FramePacer()
+    : mode(PacingMode::vsync)
+    , fps_cap(60.0f)
+    , divisor(1)
+    , rate_limit(0.0f)
+    , frame_start(Clock::now())
+    , deadline(frame_start)
+    , spin_ms(INITIAL_SPIN_MS)
+    , work_ms(0.0f)
+    , work_frames(0)
+    , intervals()
+    , head(0)
+    , filled(0) {}
+
+void FramePacer::set_mode(PacingMode new_mode, int cap) {
+    mode = new_mode;
+    fps_cap = static_cast<float>(std::max(cap, 1));
+    divisor = 1;
+    work_ms = 0.0f;
+    work_frames = 0;
+    frame_start = Clock::now();
+    deadline = frame_start;
+    filled = 0;
+
+    // Limiting is done by us
+    SetTargetFPS(0);
+    if (mode == PacingMode::vsync) {
+        SetWindowState(FLAG_VSYNC_HINT);
+    }
+    else {
+        ClearWindowState(FLAG_VSYNC_HINT);
+    }
+
+    spdlog::info(
+        "Frame pacing: {}, target {} fps", get_pacing_mode_name(mode), get_target_fps());
+}
+
+PacingMode FramePacer::get_mode() const {
+    return mode;
+}
+
+float FramePacer::get_target_fps() const {
+    const float mode_fps = get_mode_fps();
+    if (rate_limit > 0.0f && (mode_fps == 0.0f || rate_limit < mode_fps)) {
+        return rate_limit;
+    }
+
+    return mode_fps;
+}
+
+void FramePacer::set_rate_limit(float fps) {
+    rate_limit = fps;
+}
+
+float FramePacer::get_budget_fps() const {
+    const float mode_fps = get_mode_fps();
+    if (mode_fps > 0.0f) {
+        return mode_fps;
+    }
+
+    const int refresh_rate = GetMonitorRefreshRate(GetCurrentMonitor());
+    return refresh_rate > 0 ? static_cast<float>(refresh_rate) : 60.0f;
+}
+
+float FramePacer::get_mode_fps() const {
+    switch (mode) {
+    case PacingMode::cap:
+        return fps_cap;
+    case PacingMode::adaptive:
+        return fps_cap / divisor;
+    default:
+        return 0.0f;
+    }
+}
+
+void FramePacer::wait_until(Clock::time_point target) {
+    const auto remaining = target - Clock::now();
+    const auto spin = std::chrono::duration<float, std::milli>(spin_ms);
+
+    // Shrinks unless sleep below proves it's still needed. Also done when there
+    // is no sleep at all, so spin can never get stuck covering the whole frame.
+    float new_spin_ms = spin_ms * SPIN_DECAY;
+    if (remaining > spin) {
+        const auto sleep_time =
+            std::chrono::duration_cast<Clock::duration>(remaining - spin);
+        const auto before = Clock::now();
+        std::this_thread::sleep_for(sleep_time);
+        const float overshoot = to_ms(Clock::now() - before - sleep_time);
+
+        // Sleep got late, grow (but not all at once, a single hiccup isn't a
+        // reason to spin for long)
+        if (overshoot * 1.5f > spin_ms) {
+            new_spin_ms = std::min(overshoot * 1.5f, spin_ms + MAX_SPIN_GROWTH_MS);
+        }
+    }
+    spin_ms = std::clamp(new_spin_ms, MIN_SPIN_MS, MAX_SPIN_MS);
+
+    while (Clock::now() < target) {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::adapt(float frame_work_ms) {
+    work_ms += frame_work_ms;
+    work_frames++;
+    if (work_frames < ADAPT_WINDOW) {
+        return;
+    }
+
+    const float average = work_ms / work_frames;
+    work_ms = 0.0f;
+    work_frames = 0;
+
+    const float budget = 1000.0f * divisor / fps_cap;
+    const float higher_budget = 1000.0f * (divisor - 1) / fps_cap;
+    if (average > budget * ADAPT_DOWN && divisor < MAX_DIVISOR) {
+        divisor++;
+        spdlog::info("Frame pacing: lowering target to {} fps", get_target_fps());
+    }
+    else if (divisor > 1 && average < higher_budget * ADAPT_UP) {
+        divisor--;
+        spdlog::info("Frame pacing: raising target to {} fps", get_target_fps());
+    }
+}
+
+void FramePacer::wait() {
+    auto now = Clock::now();
+
+    const float target_fps = get_target_fps();
+    if (target_fps > 0.0f) {
+        if (mode == PacingMode::adaptive && target_fps == get_mode_fps()) {
+            adapt(to_ms(now - frame_start));
+        }
+
+        deadline += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<float>(1.0f / target_fps));
+        if (deadline < now) {
+            // Frame took too long. Don't try to catch up, since that would
+            // deliver next frames too early.
+            deadline = now;
+        }
+        else {
+            wait_until(deadline);
+            now = Clock::now();
+        }
+    }
+
+    intervals[head] = to_ms(now - frame_start);
+    head = (head + 1) % HISTORY;
+    filled = std::min(filled + 1, HISTORY);
+    frame_start = now;
+}
+
+FramePacer::Stats FramePacer::get_stats() const {
+    const float target = get_target_fps();
+    Stats stats = {target > 0.0f ? 1000.0f / target : 0.0f, 0.0f, 0.0f, 0.0f};
+    if (filled == 0) {
+        return stats;
+    }
+
+    for (std::size_t i = 0; i < filled; i++) {
+        stats.average += intervals[i];
+    }
+    stats.average /= filled;
+
+    float variance = 0.0f;
+    for (std::size_t i = 0; i < filled; i++) {
+        const float deviation = intervals[i] - stats.average;
+        variance += deviation * deviation;
+        stats.worst = std::max(stats.worst, std::abs(deviation));
+    }
+    stats.jitter = std::sqrt(variance / filled);
+
+    return stats;
+}
+
+void FramePacer::report() const {
+    const auto stats = get_stats();
+    spdlog::info(
+        "Frame pacing ({}): average {:.3f} ms, jitter {:.3f} ms, worst {:.3f} ms off",
+        get_pacing_mode_name(mode),
+        stats.average,
+        stats.jitter,
+        stats.worst);
+}
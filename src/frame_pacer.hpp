@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class PacingMode : std::uint8_t {
+    // Swap buffers in sync with display, without any limiting of our own
+    vsync,
+    // Limit frame rate to fps_cap
+    cap,
+    // Render as fast as possible
+    uncapped,
+    // Same as cap, but drops to fractions of it (1/2, 1/3...) if frames don't
+    // fit into budget, so these are delivered evenly instead of fluctuating
+    adaptive,
+    count
+};
+
+// Returns vsync for unknown names
+PacingMode parse_pacing_mode(const std::string& name);
+const char* get_pacing_mode_name(PacingMode mode);
+
+// Paces frames according to selected mode. Raylib's own limiter is disabled,
+// since it either sleeps (which is too coarse on most systems) or busy-waits
+// for the whole frame. Instead, the wait sleeps for most of the remaining time
+// and spins through the rest. Sleep's overshoot is measured on the go, so the
+// spinning part stays as short as possible - and never longer than 2 ms.
+class FramePacer {
+public:
+    static constexpr std::size_t HISTORY = 240;
+
+    struct Stats {
+        // All in milliseconds
+        float target;
+        float average;
+        // Standard deviation of frame intervals
+        float jitter;
+        // The largest difference between frame interval and the average
+        float worst;
+    };
+
+    FramePacer();
+
+    // Also toggles vsync. Must be called after window has been created.
+    void set_mode(PacingMode mode, int fps_cap);
+    PacingMode get_mode() const;
+    // Frame rate limiter currently aims for. 0 if there is no limit.
+    float get_target_fps() const;
+    // Additional limit on top of selected mode (used to save power while idle).
+    // Applied if lower than mode's own target. 0 to disable.
+    void set_rate_limit(float fps);
+    // Frame rate game has to keep up with: target of selected mode, or display's
+    // refresh rate if mode has no target of its own
+    float get_budget_fps() const;
+
+    // Must be called once per frame, right before buffers get swapped. Waits
+    // for frame's deadline, if needed.
+    void wait();
+
+    Stats get_stats() const;
+    // Log jitter stats
+    void report() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    PacingMode mode;
+    float fps_cap;
+    // Current fraction of fps_cap adaptive mode is running at
+    int divisor;
+    float rate_limit;
+
+    Clock::time_point frame_start;
+    Clock::time_point deadline;
+
+    // Time to spin through instead of sleeping, in ms
+    float spin_ms;
+
+    // Time spent on frames before waiting, for adaptive mode
+    float work_ms;
+    int work_frames;
+
+    std::array<float, HISTORY> intervals;
+    std::size_t head;
+    std::size_t filled;
+
+    void wait_until(Clock::time_point target);
+    void adapt(float frame_work_ms);
+    // Target of selected mode itself, without rate limit
+    float get_mode_fps() const;
+};
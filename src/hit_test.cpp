@@ -0,0 +1,150 @@
+#include "hit_test.hpp"
+
+#include "components.hpp"
+
+#include <box2d/b2_collision.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Enough for a typical click without any reallocations
+static constexpr std::size_t RESULTS_RESERVE = 64;
+// Long segments are split into parts of this length, so their broadphase boxes
+// stay tight and cost grows with segment's length instead of its bounding area
+static constexpr float SWEEP_STEP = 64.0f;
+
+HitTester::HitTester(const PhysicsShards* shards)
+    : shards(shards) {
+    results.reserve(RESULTS_RESERVE);
+    probe_transform.SetIdentity();
+}
+
+const std::vector<entt::entity>& HitTester::query_point(b2Vec2 point) {
+    results.clear();
+    mode = Mode::point;
+    center = point;
+
+    query(b2AABB{point, point});
+
+    return results;
+}
+
+const std::vector<entt::entity>& HitTester::query_radius(b2Vec2 pos, float r) {
+    results.clear();
+    mode = Mode::radius;
+    center = pos;
+    radius = r;
+    probe.m_p = pos;
+    probe.m_radius = r;
+
+    const b2Vec2 extents = {r, r};
+    query(b2AABB{pos - extents, pos + extents});
+
+    return results;
+}
+
+const std::vector<entt::entity>& HitTester::query_segments(
+    const Segment* segments, std::size_t amount, float r) {
+    results.clear();
+    mode = Mode::segment;
+    radius = r;
+    edge_probe.m_radius = r;
+
+    for (std::size_t i = 0; i < amount; i++) {
+        const b2Vec2 start = segments[i].start;
+        const b2Vec2 delta = segments[i].end - start;
+        const int steps = std::max(1, static_cast<int>(std::ceil(delta.Length() / SWEEP_STEP)));
+
+        for (int step = 0; step < steps; step++) {
+            query_segment(
+                start + (static_cast<float>(step) / steps) * delta,
+                start + (static_cast<float>(step + 1) / steps) * delta);
+        }
+    }
+
+    // Neighbouring parts of the sweep often report the same entities
+    std::sort(results.begin(), results.end());
+    results.erase(std::unique(results.begin(), results.end()), results.end());
+
+    return results;
+}
+
+void HitTester::query_segment(b2Vec2 start, b2Vec2 finish) {
+    center = start;
+    end = finish;
+    edge_probe.SetTwoSided(start, finish);
+
+    const b2Vec2 extents = {radius, radius};
+    query(b2AABB{b2Min(start, finish) - extents, b2Max(start, finish) + extents});
+}
+
+void HitTester::query(const b2AABB& area) {
+    shards->for_each_world_in(
+        area.lowerBound.x, area.upperBound.x, [this, &area](const b2World& world) {
+            world.QueryAABB(this, area);
+        });
+}
+
+const std::vector<entt::entity>& HitTester::get_results() const {
+    return results;
+}
+
+bool HitTester::overlaps_probe(const b2Fixture* fixture) const {
+    const b2Shape* shape = fixture->GetShape();
+    const b2Transform& transform = fixture->GetBody()->GetTransform();
+
+    // Fast path for balloons, without going through GJK
+    if (shape->GetType() == b2Shape::e_circle) {
+        const auto circle = static_cast<const b2CircleShape*>(shape);
+        const b2Vec2 pos = b2Mul(transform, circle->m_p);
+        const float reach = radius + circle->m_radius;
+        return get_distance_squared(pos) <= reach * reach;
+    }
+
+    const b2Shape* probe_shape = &probe;
+    if (mode == Mode::segment) {
+        probe_shape = &edge_probe;
+    }
+
+    for (int32 i = 0; i < shape->GetChildCount(); i++) {
+        if (b2TestOverlap(probe_shape, 0, shape, i, probe_transform, transform)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+float HitTester::get_distance_squared(b2Vec2 pos) const {
+    if (mode != Mode::segment) {
+        return b2DistanceSquared(pos, center);
+    }
+
+    // Distance to the closest point of segment
+    const b2Vec2 delta = end - center;
+    const float length_squared = delta.LengthSquared();
+    float t = 0.0f;
+    if (length_squared > 0.0f) {
+        t = std::clamp(b2Dot(pos - center, delta) / length_squared, 0.0f, 1.0f);
+    }
+
+    return b2DistanceSquared(pos, center + t * delta);
+}
+
+bool HitTester::ReportFixture(b2Fixture* fixture) {
+    // Ghost's source is found in its own world
+    if (fixture->GetBody()->GetType() == b2_staticBody
+        || PhysicsShards::is_ghost(fixture->GetBody())) {
+        return true;
+    }
+
+    const bool hit =
+        mode == Mode::point ? fixture->TestPoint(center) : overlaps_probe(fixture);
+
+    // Bodies have a single fixture each, thus there are no duplicates to skip
+    if (hit) {
+        results.push_back(get_entity(fixture));
+    }
+
+    return true;
+}
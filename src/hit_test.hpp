@@ -0,0 +1,69 @@
+#pragma once
+
+#include "physics_shards.hpp"
+
+#include <box2d/box2d.h>
+#include <entt/entt.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Exact hit-testing against physics shapes. Candidates come from world's
+// broadphase (which only knows about fat AABBs) and then get filtered by their
+// actual shapes. Results are written into buffer that is reused between
+// queries, thus once it has grown to fit the largest result, queries no longer
+// allocate. Static bodies (walls) are never reported. Only physics shards whose
+// strips are near the queried area are asked.
+class HitTester : private b2QueryCallback {
+public:
+    struct Segment {
+        b2Vec2 start;
+        b2Vec2 end;
+    };
+
+    HitTester(const PhysicsShards* shards);
+
+    HitTester(const HitTester&) = delete;
+    HitTester& operator=(const HitTester&) = delete;
+
+    // Entities whose shapes contain the point
+    const std::vector<entt::entity>& query_point(b2Vec2 point);
+    // Entities whose shapes overlap the circle. Meant for area damage.
+    const std::vector<entt::entity>& query_radius(b2Vec2 center, float radius);
+    // Entities touched by a circle of specified radius, swept along each of
+    // segments. Each entity is reported once, even if crossed by multiple
+    // segments.
+    const std::vector<entt::entity>& query_segments(
+        const Segment* segments, std::size_t amount, float radius);
+
+    // Results of the last query. Invalidated by the next one.
+    const std::vector<entt::entity>& get_results() const;
+
+private:
+    enum class Mode {
+        point,
+        radius,
+        segment
+    };
+
+    const PhysicsShards* shards;
+    std::vector<entt::entity> results;
+
+    Mode mode = Mode::point;
+    // Queried point, circle's center or segment's start, depending on mode
+    b2Vec2 center = {0.0f, 0.0f};
+    b2Vec2 end = {0.0f, 0.0f};
+    float radius = 0.0f;
+    // Query area as a shape, for narrowphase against non-circle fixtures
+    b2CircleShape probe;
+    // Same for swept queries. Edge's radius makes it a capsule.
+    b2EdgeShape edge_probe;
+    b2Transform probe_transform;
+
+    void query(const b2AABB& area);
+    void query_segment(b2Vec2 start, b2Vec2 end);
+
+    bool ReportFixture(b2Fixture* fixture) override;
+    bool overlaps_probe(const b2Fixture* fixture) const;
+    float get_distance_squared(b2Vec2 pos) const;
+};
@@ -0,0 +1,143 @@
+#include "idle.hpp"
+
+#include "platform.hpp"
+
+#include <raylib.h>
+
+#include <spdlog/spdlog.h>
+
+static constexpr const char* STATE_NAMES[IdleGovernor::STATES] = {
+    "active",
+    "idle",
+    "background",
+};
+
+static constexpr float IDLE_FPS = 15.0f;
+static constexpr float BACKGROUND_FPS = 5.0f;
+// Full rate is kept for that long after input, so hover effects and such don't
+// stutter right after the mouse stops moving
+static constexpr double WAKE_SECONDS = 1.0;
+
+// Range of keyboard keys in raylib's KeyboardKey
+static constexpr int FIRST_KEY = KEY_SPACE;
+static constexpr int LAST_KEY = KEY_KB_MENU;
+
+IdleGovernor::IdleGovernor(Platform* platform)
+    : platform(platform)
+    , enabled(true)
+    , state(IdleState::active)
+    , wake_left(WAKE_SECONDS)
+    , last_time(GetTime())
+    , last_cpu_time(platform->get_cpu_time())
+    , wall_times()
+    , cpu_times() {}
+
+void IdleGovernor::set_enabled(bool value) {
+    enabled = value;
+    if (!enabled) {
+        state = IdleState::active;
+    }
+}
+
+bool IdleGovernor::has_input() {
+    const Vector2 delta = GetMouseDelta();
+    if (delta.x != 0.0f || delta.y != 0.0f || GetMouseWheelMove() != 0.0f ||
+        GetTouchPointCount() > 0) {
+        return true;
+    }
+
+    for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; button++) {
+        if (IsMouseButtonDown(button) || IsMouseButtonReleased(button)) {
+            return true;
+        }
+    }
+
+    // GetKeyPressed() would be cheaper, but it consumes keys from the queue
+    for (int key = FIRST_KEY; key <= LAST_KEY; key++) {
+        if (IsKeyPressed(key) || IsKeyReleased(key)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void IdleGovernor::update(bool scene_idle) {
+    const double now = GetTime();
+    const double cpu_time = platform->get_cpu_time();
+
+    // Time since previous update has been spent in state chosen back then
+    const auto idx = static_cast<std::size_t>(state);
+    wall_times[idx] += now - last_time;
+    cpu_times[idx] += cpu_time - last_cpu_time;
+    const double dt = now - last_time;
+    last_time = now;
+    last_cpu_time = cpu_time;
+
+    if (!enabled) {
+        return;
+    }
+
+    if (!IsWindowFocused() || IsWindowMinimized()) {
+        state = IdleState::background;
+        // Coming back to the window counts as input
+        wake_left = WAKE_SECONDS;
+        return;
+    }
+
+    if (!scene_idle || has_input()) {
+        wake_left = WAKE_SECONDS;
+    }
+    else if (wake_left > 0.0) {
+        wake_left -= dt;
+    }
+
+    const IdleState new_state = wake_left > 0.0 ? IdleState::active : IdleState::idle;
+    if (new_state != state) {
+        spdlog::debug("Switching to {} state", get_name(new_state));
+    }
+    state = new_state;
+}
+
+IdleState IdleGovernor::get_state() const {
+    return state;
+}
+
+float IdleGovernor::get_fps_limit() const {
+    switch (state) {
+    case IdleState::idle:
+        return IDLE_FPS;
+    case IdleState::background:
+        return BACKGROUND_FPS;
+    default:
+        return 0.0f;
+    }
+}
+
+float IdleGovernor::get_cpu_usage(IdleState s) const {
+    const auto idx = static_cast<std::size_t>(s);
+    if (wall_times[idx] <= 0.0) {
+        return 0.0f;
+    }
+
+    return static_cast<float>(cpu_times[idx] / wall_times[idx] * 100.0);
+}
+
+const char* IdleGovernor::get_name(IdleState s) {
+    return STATE_NAMES[static_cast<std::size_t>(s)];
+}
+
+void IdleGovernor::report() const {
+    for (std::size_t i = 0; i < STATES; i++) {
+        const auto s = static_cast<IdleState>(i);
+        if (wall_times[i] <= 0.0) {
+            continue;
+        }
+
+        spdlog::info(
+            "Spent {:.1f} s in {} state, CPU usage {:.1f}%",
+            wall_times[i],
+            get_name(s),
+            get_cpu_usage(s));
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class Platform;
+
+// Implemented by scenes that may have nothing to animate. Scenes that don't
+// implement it are considered to be always busy.
+class IdleReporter {
+public:
+    // Returns true if scene would look the same if redrawn rarely, as long as
+    // there is no input (e.g menus, paused level)
+    virtual bool is_idle() const = 0;
+
+    virtual ~IdleReporter() = default;
+};
+
+enum class IdleState : std::uint8_t {
+    // Full frame rate
+    active,
+    // Current scene has nothing to animate
+    idle,
+    // Window is unfocused or minimized
+    background,
+    count
+};
+
+// Lowers frame rate while nothing happens on screen, and returns to full rate
+// on the very next frame after any input. Also measures how much CPU time the
+// whole process consumes in each of states.
+class IdleGovernor {
+public:
+    static constexpr std::size_t STATES = static_cast<std::size_t>(IdleState::count);
+
+    IdleGovernor(Platform* platform);
+
+    void set_enabled(bool value);
+
+    // Must be called once per frame, with whatever current scene reports
+    void update(bool scene_idle);
+
+    IdleState get_state() const;
+    // Frame rate to limit next frame to. 0 if there should be no limit.
+    float get_fps_limit() const;
+    // Share of a single core used by the process while in state, in percents
+    float get_cpu_usage(IdleState state) const;
+
+    static const char* get_name(IdleState state);
+
+    // Log CPU usage in each of states
+    void report() const;
+
+private:
+    Platform* platform;
+    bool enabled;
+    IdleState state;
+    // Time left till governor is allowed to leave active state, in seconds
+    double wake_left;
+
+    double last_time;
+    double last_cpu_time;
+    // Wall-clock and CPU time spent in each of states, in seconds
+    std::array<double, STATES> wall_times;
+    std::array<double, STATES> cpu_times;
+
+    static bool has_input();
+};
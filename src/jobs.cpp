@@ -0,0 +1,330 @@
+#include "jobs.hpp"
+
+#include <spdlog/spdlog.h>
+
+// Length of utilization measurement window
+static constexpr auto STATS_WINDOW = std::chrono::seconds(1);
+
+// Worker the current thread is, or -1 for threads that aren't workers
+static thread_local int current_worker = -1;
+// System current worker belongs to
+static thread_local JobSystem* current_system = nullptr;
+// Jobs being run by the current thread. Jobs may run other jobs while waiting,
+// and only the outermost one is timed, so nothing is counted twice.
+static thread_local int nesting = 0;
+
+JobCounter::JobCounter()
+    : pending(0) {}
+
+bool JobCounter::is_done() const {
+    return pending.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::Worker::Worker()
+    : busy_ns(0)
+    , done(0)
+    , steals(0)
+    , window_busy_ns(0)
+    , utilization(0.0f) {}
+
+JobSystem::JobSystem(std::size_t workers_amount)
+    : main_thread(std::this_thread::get_id())
+    , queued(0)
+    , stopping(false)
+    , next_worker(0)
+    , started(Clock::now())
+    , window_start(started) {
+    workers.reserve(workers_amount);
+    for (std::size_t i = 0; i < workers_amount; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // Started separately, so workers never see partially filled vector
+    for (std::size_t i = 0; i < workers_amount; i++) {
+        workers[i]->thread = std::thread(&JobSystem::work, this, i);
+    }
+
+    spdlog::info("Started job system with {} workers", workers_amount);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+std::size_t JobSystem::get_default_workers() {
+    const unsigned threads = std::thread::hardware_concurrency();
+    return threads > 1 ? threads - 1 : 0;
+}
+
+void JobSystem::run(JobCounter& counter, std::function<void()> job) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    submit({std::move(job), &counter});
+}
+
+void JobSystem::run_after(
+    JobCounter& dependency, JobCounter& counter, std::function<void()> job) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if (!dependency.is_done()) {
+            dependency.continuations.push_back({std::move(job), &counter, false});
+            return;
+        }
+    }
+    submit({std::move(job), &counter});
+}
+
+void JobSystem::run_on_main(
+    JobCounter* dependency, JobCounter& counter, std::function<void()> job) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    if (dependency != nullptr) {
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->is_done()) {
+            dependency->continuations.push_back({std::move(job), &counter, true});
+            return;
+        }
+    }
+    submit_main({std::move(job), &counter});
+}
+
+void JobSystem::submit(Job job) {
+    if (workers.empty()) {
+        execute(job, nullptr);
+        return;
+    }
+
+    // Workers push into their own deque, everyone else spreads jobs around
+    std::size_t index;
+    if (current_system == this) {
+        index = static_cast<std::size_t>(current_worker);
+    }
+    else {
+        index = next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        // Counted before the job becomes visible, else a thief could take it
+        // and decrement first, wrapping the counter around
+        queued.fetch_add(1, std::memory_order_release);
+        workers[index]->jobs.push_back(std::move(job));
+    }
+
+    // Taking the lock, so a worker that is about to sleep can't miss this
+    { std::lock_guard<std::mutex> lock(sleep_mutex); }
+    wake.notify_one();
+}
+
+void JobSystem::submit_main(Job job) {
+    std::lock_guard<std::mutex> lock(main_mutex);
+    main_jobs.push_back(std::move(job));
+}
+
+bool JobSystem::take(Job& job) {
+    if (workers.empty()) {
+        return false;
+    }
+
+    const bool is_worker = current_system == this;
+    const std::size_t own = is_worker ? static_cast<std::size_t>(current_worker) : 0;
+
+    if (is_worker) {
+        auto& worker = *workers[own];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty()) {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    for (std::size_t i = 0; i < workers.size(); i++) {
+        const std::size_t victim = (own + i + 1) % workers.size();
+        if (is_worker && victim == own) {
+            continue;
+        }
+
+        auto& worker = *workers[victim];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty()) {
+            job = std::move(worker.jobs.front());
+            worker.jobs.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            if (is_worker) {
+                workers[own]->steals.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool JobSystem::run_main_job() {
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(main_mutex);
+        if (main_jobs.empty()) {
+            return false;
+        }
+        job = std::move(main_jobs.front());
+        main_jobs.pop_front();
+    }
+
+    execute(job, nullptr);
+    return true;
+}
+
+void JobSystem::execute(Job& job, Worker* worker) {
+    const bool timed = worker != nullptr && nesting == 0;
+    const auto start = timed ? Clock::now() : Clock::time_point();
+
+    nesting++;
+    job.fn();
+    nesting--;
+
+    if (worker != nullptr) {
+        worker->done.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (timed) {
+        const auto ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+        worker->busy_ns.fetch_add(
+            static_cast<std::uint64_t>(ns.count()), std::memory_order_relaxed);
+    }
+
+    finish(job.counter);
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    // Decremented under the lock, so dependents can't be added between the
+    // counter dropping to zero and these being taken
+    std::vector<JobCounter::Continuation> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            continuations.swap(counter->continuations);
+        }
+    }
+
+    // Counter must not be touched from now on, since it may be gone already
+    for (auto& continuation : continuations) {
+        schedule(std::move(continuation));
+    }
+}
+
+void JobSystem::schedule(JobCounter::Continuation continuation) {
+    Job job = {std::move(continuation.job), continuation.counter};
+    if (continuation.main_thread) {
+        submit_main(std::move(job));
+    }
+    else {
+        submit(std::move(job));
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    const bool is_main = std::this_thread::get_id() == main_thread;
+    Worker* worker =
+        current_system == this ? workers[static_cast<std::size_t>(current_worker)].get()
+                               : nullptr;
+
+    while (!counter.is_done()) {
+        if (is_main && run_main_job()) {
+            continue;
+        }
+
+        Job job;
+        if (take(job)) {
+            execute(job, worker);
+            continue;
+        }
+
+        // Remaining jobs are being run by someone else
+        std::this_thread::yield();
+    }
+
+    // The last job may have just decremented counter and still hold its lock.
+    // Waiting for it, so counter can be safely destroyed once this returns.
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::run_main_thread_jobs() {
+    while (run_main_job()) {
+    }
+}
+
+void JobSystem::work(std::size_t index) {
+    current_worker = static_cast<int>(index);
+    current_system = this;
+    Worker* worker = workers[index].get();
+
+    while (true) {
+        Job job;
+        if (take(job)) {
+            execute(job, worker);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this] {
+            return stopping.load() || queued.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+std::size_t JobSystem::get_workers_amount() const {
+    return workers.size();
+}
+
+void JobSystem::end_frame() {
+    const auto now = Clock::now();
+    const auto elapsed = now - window_start;
+    if (elapsed < STATS_WINDOW) {
+        return;
+    }
+
+    const auto window_ns = static_cast<float>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    for (auto& worker : workers) {
+        const std::uint64_t busy = worker->busy_ns.load(std::memory_order_relaxed);
+        worker->utilization = static_cast<float>(busy - worker->window_busy_ns) / window_ns;
+        worker->window_busy_ns = busy;
+    }
+    window_start = now;
+}
+
+JobSystem::WorkerStats JobSystem::get_stats(std::size_t worker) const {
+    const auto& w = *workers[worker];
+    return {
+        w.utilization,
+        w.done.load(std::memory_order_relaxed),
+        w.steals.load(std::memory_order_relaxed)};
+}
+
+void JobSystem::report() const {
+    const auto total_ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started)
+            .count());
+
+    for (std::size_t i = 0; i < workers.size(); i++) {
+        const auto& worker = *workers[i];
+        spdlog::info(
+            "Worker {}: {} jobs, {} stolen, busy {:.2f}% of the time",
+            i,
+            worker.done.load(),
+            worker.steals.load(),
+            static_cast<double>(worker.busy_ns.load()) / total_ns * 100.0);
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Amount of unfinished jobs. Jobs started with the same counter can be waited
+// for together (fork/join), or used as dependency of other jobs. Counter must
+// outlive everything that has been started with it, i.e it may only be
+// destroyed after JobSystem::wait() on it has returned.
+class JobCounter {
+private:
+    friend class JobSystem;
+
+    struct Continuation {
+        std::function<void()> job;
+        JobCounter* counter;
+        bool main_thread;
+    };
+
+    std::atomic<int> pending;
+    // Jobs waiting for this counter to drop to zero
+    std::mutex mutex;
+    std::vector<Continuation> continuations;
+
+public:
+    JobCounter();
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool is_done() const;
+};
+
+// Work-stealing job system. Each worker has its own deque: it takes its own
+// jobs from the back (the most recent, thus the hottest in cache) and, once
+// it runs out of these, steals from the front of others' deques. Jobs started
+// from outside of workers are spread between them in round-robin manner.
+//
+// Threads that wait for a counter don't block, but run pending jobs meanwhile.
+// Thus jobs may start and wait for other jobs, and the main thread helps too.
+//
+// raylib and GL may only be used from the main thread. Jobs that need these
+// must be started with run_on_main(), and are executed either by
+// run_main_thread_jobs() (once per frame), or while main thread waits.
+class JobSystem {
+public:
+    struct WorkerStats {
+        // Share of last measurement window spent running jobs, 0-1
+        float utilization;
+        std::size_t jobs;
+        // Jobs taken from other workers
+        std::size_t steals;
+    };
+
+    // 0 workers makes every job run inline, right when it's started
+    JobSystem(std::size_t workers);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Amount of worker threads for this machine: one per hardware thread, minus
+    // the main thread
+    static std::size_t get_default_workers();
+
+    void run(JobCounter& counter, std::function<void()> job);
+    // Start job once dependency is done
+    void run_after(JobCounter& dependency, JobCounter& counter, std::function<void()> job);
+    // Run job on the main thread once dependency (if any) is done
+    void run_on_main(JobCounter* dependency, JobCounter& counter, std::function<void()> job);
+
+    // Returns once all jobs of counter are done, running pending jobs meanwhile
+    void wait(JobCounter& counter);
+
+    // Must be called once per frame on the main thread
+    void run_main_thread_jobs();
+
+    // Calls fn(begin, end) for ranges of up to grain items, in parallel. The
+    // first range runs on the calling thread.
+    template <typename F>
+    void parallel_for(std::size_t count, std::size_t grain, F&& fn) {
+        grain = std::max<std::size_t>(grain, 1);
+        if (count <= grain || workers.empty()) {
+            fn(std::size_t(0), count);
+            return;
+        }
+
+        JobCounter counter;
+        for (std::size_t begin = grain; begin < count; begin += grain) {
+            const std::size_t end = std::min(begin + grain, count);
+            run(counter, [&fn, begin, end] { fn(begin, end); });
+        }
+        fn(std::size_t(0), grain);
+        wait(counter);
+    }
+
+    std::size_t get_workers_amount() const;
+    // Must be called once per frame, updates utilization
+    void end_frame();
+    WorkerStats get_stats(std::size_t worker) const;
+    // Log per-worker totals
+    void report() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        std::function<void()> fn;
+        JobCounter* counter;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<Job> jobs;
+
+        // Written by worker itself, read by main thread
+        std::atomic<std::uint64_t> busy_ns;
+        std::atomic<std::size_t> done;
+        std::atomic<std::size_t> steals;
+
+        // Only touched by main thread
+        std::uint64_t window_busy_ns;
+        float utilization;
+
+        Worker();
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::thread::id main_thread;
+
+    std::mutex main_mutex;
+    std::deque<Job> main_jobs;
+
+    // Idle workers sleep till there are queued jobs
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<std::size_t> queued;
+    std::atomic<bool> stopping;
+    std::atomic<std::size_t> next_worker;
+
+    Clock::time_point started;
+    Clock::time_point window_start;
+
+    void submit(Job job);
+    void submit_main(Job job);
+    // Take a job: own one first (if called by worker), else steal
+    bool take(Job& job);
+    bool run_main_job();
+    void execute(Job& job, Worker* worker);
+    // Mark job of counter as done and start everything waiting for it
+    void finish(JobCounter* counter);
+    void schedule(JobCounter::Continuation continuation);
+    void work(std::size_t index);
+};
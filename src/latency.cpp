@@ -0,0 +1,109 @@
+#include "latency.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+static float to_ms(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+InputLatency::InputLatency()
+    : pending()
+    , pending_amount(0)
+    , last_frame_end(Clock::now())
+    , latencies()
+    , handle_times()
+    , head(0)
+    , filled(0) {}
+
+InputLatency& InputLatency::get() {
+    static InputLatency instance;
+    return instance;
+}
+
+void InputLatency::begin_frame() {
+    if (pending_amount == 0) {
+        return;
+    }
+
+    const auto now = Clock::now();
+    std::size_t left = 0;
+    for (std::size_t i = 0; i < pending_amount; i++) {
+        const auto& p = pending[i];
+        // Inputs handled during current frame (if this is called after scene's
+        // update) have to wait for the next swap
+        if (!p.drawn) {
+            pending[left++] = p;
+            continue;
+        }
+
+        latencies[head] = to_ms(now - p.input);
+        handle_times[head] = to_ms(p.handled - p.input);
+        head = (head + 1) % HISTORY;
+        filled = std::min(filled + 1, HISTORY);
+    }
+    pending_amount = left;
+}
+
+void InputLatency::end_frame() {
+    for (std::size_t i = 0; i < pending_amount; i++) {
+        pending[i].drawn = true;
+    }
+    last_frame_end = Clock::now();
+}
+
+void InputLatency::record_input() {
+    if (pending_amount == MAX_PENDING) {
+        return;
+    }
+
+    pending[pending_amount++] = {last_frame_end, Clock::now(), false};
+}
+
+InputLatency::Stats InputLatency::get_stats() const {
+    Stats stats;
+    if (filled == 0) {
+        return stats;
+    }
+
+    std::array<float, HISTORY> sorted;
+    std::copy(latencies.begin(), latencies.begin() + filled, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + filled);
+
+    const auto percentile = [&](float p) {
+        return sorted[static_cast<std::size_t>(p * (filled - 1))];
+    };
+
+    stats.samples = filled;
+    stats.min = sorted[0];
+    stats.p50 = percentile(0.5f);
+    stats.p95 = percentile(0.95f);
+    stats.p99 = percentile(0.99f);
+    stats.max = sorted[filled - 1];
+
+    for (std::size_t i = 0; i < filled; i++) {
+        stats.handled += handle_times[i];
+    }
+    stats.handled /= filled;
+
+    return stats;
+}
+
+void InputLatency::report() const {
+    const auto stats = get_stats();
+    if (stats.samples == 0) {
+        return;
+    }
+
+    spdlog::info(
+        "Input to present latency over {} inputs: min {:.2f} ms, p50 {:.2f} ms, p95 "
+        "{:.2f} ms, p99 {:.2f} ms, max {:.2f} ms. Handled after {:.2f} ms on average",
+        stats.samples,
+        stats.min,
+        stats.p50,
+        stats.p95,
+        stats.p99,
+        stats.max,
+        stats.handled);
+}
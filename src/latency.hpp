@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+// Measures how long it takes for player's input to show up on screen.
+// Raylib polls events right after swapping buffers and doesn't expose their
+// timestamps, thus input is considered to arrive at the end of the frame during
+// which it has been polled (the earliest moment game could know about it).
+// Frame is considered presented once the next frame begins, i.e when buffer
+// swap (that blocks on vsync) has returned. Display's own scanout and response
+// time can't be measured from inside the game and aren't included.
+class InputLatency {
+public:
+    static constexpr std::size_t HISTORY = 256;
+    // Inputs handled during the same frame, waiting for it to be presented
+    static constexpr std::size_t MAX_PENDING = 16;
+
+    struct Stats {
+        std::size_t samples = 0;
+        // All in milliseconds. Percentiles are of input to present latency.
+        float min = 0.0f;
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        float max = 0.0f;
+        // Average time from input to game code reacting on it
+        float handled = 0.0f;
+    };
+
+    static InputLatency& get();
+
+    // Must be called once per frame, before drawing anything
+    void begin_frame();
+    // Must be called once per frame, after everything has been drawn
+    void end_frame();
+
+    // Called by game code when it reacts on input polled for current frame
+    void record_input();
+
+    Stats get_stats() const;
+    // Log latency distribution
+    void report() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        Clock::time_point input;
+        Clock::time_point handled;
+        bool drawn;
+    };
+
+    InputLatency();
+
+    std::array<Pending, MAX_PENDING> pending;
+    std::size_t pending_amount;
+
+    Clock::time_point last_frame_end;
+
+    // Input to present and input to handled times, in ms
+    std::array<float, HISTORY> latencies;
+    std::array<float, HISTORY> handle_times;
+    std::size_t head;
+    std::size_t filled;
+};
@@ -6,9 +6,12 @@
 #include "event_screens.hpp"
 #include "common.hpp"
 #include "components.hpp"
+#include "latency.hpp"
+#include "log.hpp"
 #include "menus.hpp"
-
-#include <box2d/b2_world_callbacks.h>
+#include "profiler.hpp"
+#include "trace.hpp"
+#include "scene_cache.hpp"
 
 #include <entt/entity/entity.hpp>
 #include <entt/entity/fwd.hpp>
@@ -18,20 +21,66 @@
 
 #include <raylib.h>
 #include <raymath.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <random>
 
 #include <spdlog/spdlog.h>
 
 const float ADDITIONAL_ROOM_HEIGHT = 100.0f;
 const float CAMERA_MOVE_STEP = 30.0f;
+// Enough to fit per-frame removal lists for a few thousands of bodies
+const std::size_t FRAME_ARENA_SIZE = 64 * 1024;
+// Events of each type that fit without growing. Splash may hit more than that
+// at once, but then storage grows and stays that large.
+const std::size_t EVENTS_RESERVE = 256;
+// Hard cap on confetti. Quality governor may lower it further.
+const std::size_t MAX_PARTICLES = 16384;
+
+// Radius of area damage dealt by right click
+const float SPLASH_RADIUS = 60.0f;
+// Half of the blade's width in slicing mode
+const float SLICE_RADIUS = 4.0f;
+// Segments per ball at full quality
+const int CIRCLE_SEGMENTS = 36;
+const float MIN_BALL_RADIUS = 10.0f;
+const float MAX_BALL_RADIUS = 60.0f;
+// One in that many balls is explosive
+const int EXPLOSIVE_CHANCE = 8;
+const float EXPLOSION_RADIUS = 100.0f;
+// Explosions detonated per frame, the rest wait for the next frames
+const std::size_t CHAIN_BUDGET = 16;
+// Narrower strips would have most of balls crossing their edges
+const float MIN_STRIP_WIDTH = 256.0f;
+
+// Milliseconds since start
+static float elapsed_ms(std::chrono::steady_clock::time_point start) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<float, std::milli>(elapsed).count();
+}
+
+// Amount of physics shards requested by settings, limited by room's width
+static std::size_t get_shards_amount(App* app, float room_width) {
+    int amount = app->config->settings["physics_shards"].value_or(1);
+    // One per hardware thread
+    if (amount <= 0) {
+        amount = static_cast<int>(app->jobs->get_workers_amount()) + 1;
+    }
+    const int max_amount = std::max(1, static_cast<int>(room_width / MIN_STRIP_WIDTH));
+    return static_cast<std::size_t>(std::clamp(amount, 1, max_amount));
+}
 
 Wind::Wind(
-    b2World* world,
+    PhysicsShards* shards,
+    GameplayEvents* events,
     float min_timer_length,
     float max_timer_length,
     float min_power,
     float max_power)
-    : world(world)
+    : shards(shards)
+    , events(events)
     , min_timer_length(min_timer_length)
     , max_timer_length(max_timer_length)
     , min_power(min_power)
@@ -40,25 +89,41 @@ Wind::Wind(
     timer.start();
 }
 
-void Wind::blow(b2Vec2 wind) {
-    spdlog::info("Blowing wind with {}, {} power", wind.x, wind.y);
-    b2Body* last_body = world->GetBodyList();
+void Wind::set_params(
+    float min_timer_length, float max_timer_length, float min_power, float max_power) {
+    this->min_timer_length = min_timer_length;
+    this->max_timer_length = max_timer_length;
+    this->min_power = min_power;
+    this->max_power = max_power;
+}
 
+void Wind::blow(b2Vec2 wind) {
     int i = 0;
-    while(last_body != nullptr) {
-        i++;
-        // This should be the right way but it did not work, for some reason
-        // last_body->ApplyForceToCenter(wind, true);
-
-        // Thus temporary using this thing. Also keep in mind that we have no
-        // "weight" now, so things may move weirdly (e.g do so in perfect sync).
-        last_body->SetLinearVelocity(wind);
-        last_body = last_body->GetNext();
-    }
-    spdlog::info("Wind affected {} targets", i);
+    shards->for_each_world([wind, &i](b2World& world) {
+        b2Body* last_body = world.GetBodyList();
+
+        while(last_body != nullptr) {
+            // Synced from their sources before each step anyway
+            if (PhysicsShards::is_ghost(last_body)) {
+                last_body = last_body->GetNext();
+                continue;
+            }
+            i++;
+            // This should be the right way but it did not work, for some reason
+            // last_body->ApplyForceToCenter(wind, true);
+
+            // Thus temporary using this thing. Also keep in mind that we have no
+            // "weight" now, so things may move weirdly (e.g do so in perfect sync).
+            last_body->SetLinearVelocity(wind);
+            last_body = last_body->GetNext();
+        }
+    });
+    events->push(WindGust{wind, i});
 }
 
 void Wind::update(float dt) {
+    PROFILE_SCOPE(ProfSection::wind);
+
     if (timer.tick(dt)) {
         std::random_device rd;
         std::mt19937 gen(rd());
@@ -82,154 +147,276 @@ void Wind::update(float dt) {
     }
 }
 
-class CollisionQueryCallback : public b2QueryCallback {
-public:
-    std::vector<entt::entity> collisions;
+void Level::update_collisions_tree(float dt) {
+    // Numbers are velocity iterations and position iterations
+    shards.step(
+        dt, quality.velocity_iterations, quality.position_iterations, *app->jobs);
+    // world.ClearForces();
+}
+
+Rectangle Level::get_view() const {
+    const Vector2 top_left = GetScreenToWorld2D({0.0f, 0.0f}, camera);
+    const Vector2 bottom_right = GetScreenToWorld2D(
+        {static_cast<float>(get_window_width()), static_cast<float>(get_window_height())},
+        camera);
+    return {
+        top_left.x, top_left.y, bottom_right.x - top_left.x, bottom_right.y - top_left.y};
+}
 
-    bool ReportFixture(b2Fixture* fixture_def) override {
-        const auto body = fixture_def->GetBody();
-        if (body->GetType() == b2_staticBody)
-        {
-            return true;
+void Level::process_mouse_collisions(Vector2 mouse_pos) {
+    PROFILE_SCOPE(ProfSection::mouse);
+
+    if (is_slicing) {
+        slice_input.update(camera);
+        if (slice_input.get_segments_amount() > 0) {
+            InputLatency::get().record_input();
+            damage_entities(
+                hit_tester.query_segments(
+                    slice_input.get_segments(),
+                    slice_input.get_segments_amount(),
+                    SLICE_RADIUS),
+                1);
         }
+    }
+    else if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        InputLatency::get().record_input();
+        // TODO: make damage points customizable
+        damage_entities(hit_tester.query_point({mouse_pos.x, mouse_pos.y}), 1);
+    }
 
-        auto user_data = reinterpret_cast<FixtureUserData*>(
-            fixture_def->GetUserData().pointer);
+    if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
+        InputLatency::get().record_input();
+        damage_entities(hit_tester.query_radius({mouse_pos.x, mouse_pos.y}, SPLASH_RADIUS), 1);
+    }
+}
 
-        spdlog::info("Collided with body {}, entity {}", reinterpret_cast<uint64_t>(body), static_cast<uint32_t>(user_data->entity));
-        auto registry = user_data->registry;
-        ASSERT(registry != nullptr);
-        ASSERT(registry->valid(user_data->entity));
+void Level::draw_slices() {
+    const auto segments = slice_input.get_segments();
+    for (std::size_t i = 0; i < slice_input.get_segments_amount(); i++) {
+        DrawLineEx(
+            {segments[i].start.x, segments[i].start.y},
+            {segments[i].end.x, segments[i].end.y},
+            SLICE_RADIUS * 2.0f,
+            WHITE);
+    }
+}
 
-        collisions.push_back(user_data->entity);
+void Level::damage_entities(const std::vector<entt::entity>& targets, int dmg) {
+    for (auto entity : targets) {
+        LOG_RATE_LIMITED(
+            1.0f,
+            TRACE,
+            input,
+            "Mouse Pointer collides with {}",
+            static_cast<uint32_t>(entity));
+        ASSERT(registry.valid(entity));
 
-        return true;
+        if (registry.try_get<BallComponent>(entity) != nullptr) {
+            events.push(BalloonHit{entity, dmg});
+        }
     }
-};
-
-void Level::update_collisions_tree(float dt) {
-    // Numbers are velocity iterations and position iterations.
-    // TODO: figure out how these works
-    world.Step(dt, 6, 2);
-    // world.ClearForces();
 }
 
-void Level::process_mouse_collisions(Vector2 mouse_pos) {
-    b2AABB mouse_rect = {{mouse_pos.x, mouse_pos.y}, {mouse_pos.x, mouse_pos.y}};
+void Level::detect_escaped_balls() {
+    // Top wall is above the screen, thus balls that got past its edge are
+    // already out of player's reach
+    balls.each([this](auto entity, auto&, auto& phys, auto&, auto&) {
+        if (phys.body->GetPosition().y < 0.0f) {
+            events.push(BalloonEscaped{entity});
+        }
+    });
+}
 
-    CollisionQueryCallback query;
-    world.QueryAABB(&query, mouse_rect);
+void Level::process_events() {
+    PROFILE_SCOPE(ProfSection::events);
 
-    if (query.collisions.size() == 0) {
+    if (events.empty()) {
         return;
     }
 
-    std::vector<entt::entity> to_remove;
+    const int score_before = score;
+    const int killed_before = enemies_killed;
+    const int lifes_before = lifes;
+    FrameVector<entt::entity> to_remove(&frame_arena);
+
+    // Damage. Pops are pushed into the same queue, to be handled below.
+    for (const auto& hit : events.get<BalloonHit>()) {
+        auto& hp = registry.get<HealthComponent>(hit.entity);
+        // Already popped by an earlier hit during this frame
+        if (hp.health <= 0) {
+            continue;
+        }
+
+        hp.health -= hit.damage;
+        if (hp.health <= 0) {
+            LOG_RATE_LIMITED(
+                1.0f,
+                TRACE,
+                input,
+                "Scheduling entity {} to be removed",
+                static_cast<uint32_t>(hit.entity));
+            const auto& phys = registry.get<PhysicsBodyComponent>(hit.entity);
+            events.push(BalloonPopped{
+                hit.entity,
+                phys.body->GetPosition(),
+                registry.get<BallComponent>(hit.entity).radius});
+        }
+        else {
+            LOG_RATE_LIMITED(
+                1.0f,
+                TRACE,
+                input,
+                "Dealt {} damage to entity {}",
+                hit.damage,
+                static_cast<uint32_t>(hit.entity));
+            score += 5;
+        }
+    }
 
-    // TODO: make damage points customizable
-    int dmg = 1;
-    for (auto entity : query.collisions) {
-        if (entity == entt::null) {
-            spdlog::error(
-                "Collision returned null entity {}",
-                static_cast<uint32_t>(entity));
-            ASSERT(false);
+    for (const auto& escaped : events.get<BalloonEscaped>()) {
+        auto& hp = registry.get<HealthComponent>(escaped.entity);
+        // Popped right before it could escape
+        if (hp.health <= 0) {
+            continue;
         }
 
-        spdlog::debug(
-            "Mouse Pointer collides with {}",
-            static_cast<uint32_t>(entity));
+        hp.health = 0;
+        to_remove.push_back(escaped.entity);
+        enemies_left--;
+        events.push(PlayerDamaged{1});
+    }
 
-        const auto ball = registry.try_get<BallComponent>(entity);
-        if (ball != nullptr) {
-            auto& hp = registry.get<HealthComponent>(entity);
-            if (hp.health - dmg <= 0) {
-                spdlog::debug(
-                    "Scheduling entity {} to be removed",
-                    static_cast<uint32_t>(entity));
-                to_remove.push_back(entity);
-                enemies_left--;
-                enemies_killed++;
-                score += 15;
-                kill_counter.set_text(
-                    fmt::format("Balloons Popped: {}", enemies_killed));
-            }
-            else {
-                spdlog::debug(
-                    "Dealing {} damage to entity {}",
-                    dmg,
-                    static_cast<uint32_t>(entity));
-                hp.health -= dmg;
-                score += 5;
-            }
-            score_counter.set_text(fmt::format("Score: {}", score));
+    // Scoring
+    for (const auto& popped : events.get<BalloonPopped>()) {
+        to_remove.push_back(popped.entity);
+        enemies_left--;
+        enemies_killed++;
+        score += 15;
+    }
+
+    // Explosive balls go off during the next frames, within chain's budget
+    for (const auto& popped : events.get<BalloonPopped>()) {
+        const auto explosive = registry.try_get<ExplosiveComponent>(popped.entity);
+        if (explosive != nullptr) {
+            chain.push({popped.position, explosive->radius, 1});
+        }
+    }
+
+    // Effects
+    for (const auto& popped : events.get<BalloonPopped>()) {
+        particles.emit_pop(
+            {popped.position.x, popped.position.y},
+            popped.radius,
+            registry.get<ColorComponent>(popped.entity).color);
+    }
+
+    // Audio. Mixer would deduplicate these anyway, but there is no need to
+    // request the same clip hundreds of times.
+    if (!events.get<BalloonPopped>().empty()) {
+        app->sfx.play(SfxClip::balloon_pop);
+    }
+
+    for (const auto& damage : events.get<PlayerDamaged>()) {
+        lifes -= damage.damage;
+    }
+
+    for ([[maybe_unused]] const auto& gust : events.get<WindGust>()) {
+        LOG_DEBUG(
+            wind,
+            "Wind gust of {}, {} power affected {} bodies",
+            gust.velocity.x,
+            gust.velocity.y,
+            gust.bodies);
+    }
+
+    // HUD, once per frame
+    if (score != score_before) {
+        score_counter.set_text(fmt::format("Score: {}", score));
+    }
+    if (enemies_killed != killed_before) {
+        kill_counter.set_text(fmt::format("Balloons Popped: {}", enemies_killed));
+    }
+    if (lifes != lifes_before) {
+        life_counter.set_text(fmt::format("Lifes: {}", lifes));
+        spdlog::info("Player HP has been decreased to {}", lifes);
+        if (lifes <= 0 && !is_gameover) {
+            gameover_screen.set_body_text(fmt::format(
+                "Final Score: {}\nBalloons Popped: {}", score, enemies_killed));
+            is_gameover = true;
         }
     }
 
+    // Single removal pass for everything that has left the level
     for (auto e : to_remove) {
-        spdlog::info("Destroying entity {}", static_cast<uint32_t>(e));
+        LOG_RATE_LIMITED(
+            1.0f, TRACE, input, "Destroying entity {}", static_cast<uint32_t>(e));
         registry.destroy(e);
     }
 
-    validate_physics();
+    if (!to_remove.empty()) {
+        checker.check();
+    }
+
+    events.clear();
 }
 
-void Level::spawn_walls() {
-    const float thickness = 10.0f;
+void Level::spawn_wall(Vector2 pos, Vector2 size) {
+    entt::entity wall = registry.create();
+    auto& rect_comp = registry.emplace<RectangleComponent>(wall);
+    auto& phys_comp = registry.emplace<PhysicsBodyComponent>(wall);
 
-    const Vector2 positions[4] = {
-        {get_window_width()/2.0f, get_window_height()+ADDITIONAL_ROOM_HEIGHT},
-        {get_window_width()/2.0f, -ADDITIONAL_ROOM_HEIGHT},
-        {0.0f, get_window_height()/2.0f},
-        {static_cast<float>(get_window_width()), get_window_height()/2.0f},
-    };
-
-    const Vector2 sizes[4] = {
-        {static_cast<float>(get_window_width()), thickness},
-        {static_cast<float>(get_window_width()), thickness},
-        {thickness, get_window_height()+ADDITIONAL_ROOM_HEIGHT*2},
-        {thickness, get_window_height()+ADDITIONAL_ROOM_HEIGHT*2},
-    };
-
-    for (auto i = 0u; i < 4; ++i) {
-        entt::entity wall = registry.create();
-        auto& rect_comp = registry.emplace<RectangleComponent>(wall);
-        auto& phys_comp = registry.emplace<PhysicsBodyComponent>(wall);
-        registry.emplace<ColorComponent>(wall, RED);
-        phys_comp.user_data->entity = wall;
-        phys_comp.user_data->registry = &registry;
+    b2BodyDef body_def;
+    body_def.type = b2_staticBody;
 
-        b2BodyDef body_def;
-        body_def.type = b2_staticBody;
+    body_def.position.Set(pos.x, pos.y);
+    body_def.angle = 0.0f;
+    body_def.userData.pointer = to_user_data(wall);
+    phys_comp.body = shards.get_world_at(pos.x).CreateBody(&body_def);
 
-        const auto& pos = positions[i];
-        body_def.position.Set(pos.x, pos.y);
-        body_def.angle = 0.0f;
-        phys_comp.body = world.CreateBody(&body_def);
+    auto half_size = size;
+    half_size.x *= 0.5f;
+    half_size.y *= 0.5f;
 
-        auto half_size = sizes[i];
-        half_size.x *= 0.5f;
-        half_size.y *= 0.5f;
+    b2PolygonShape box;
+    box.SetAsBox(half_size.x, half_size.y);
+    rect_comp.size = size;
+    rect_comp.half_size = half_size;
 
-        b2PolygonShape box;
-        box.SetAsBox(half_size.x, half_size.y);
-        rect_comp.size = sizes[i];
-        rect_comp.half_size = half_size;
+    b2FixtureDef fixture_def;
+    fixture_def.shape = &box;
+    fixture_def.density = 1.0f;
+    fixture_def.friction = 0.3f;
+    fixture_def.userData.pointer = to_user_data(wall);
 
-        b2FixtureDef fixture_def;
-        fixture_def.shape = &box;
-        fixture_def.density = 1.0f;
-        fixture_def.friction = 0.3f;
-        fixture_def.userData.pointer = reinterpret_cast<uintptr_t>(phys_comp.user_data.get());
+    phys_comp.body->CreateFixture(&fixture_def);
 
-        phys_comp.body->CreateFixture(&fixture_def);
+    // Completes the set of walls group, which moves wall's components around.
+    // Thus must be the last one, once references above are no longer used.
+    registry.emplace<ColorComponent>(wall, RED);
+}
+
+void Level::spawn_walls() {
+    const float thickness = 10.0f;
+
+    // Floor and ceiling span the whole room, thus each shard gets its own piece
+    for (std::size_t i = 0; i < shards.get_amount(); i++) {
+        const float begin = shards.get_strip_begin(i);
+        const float width = shards.get_strip_end(i) - begin;
+        spawn_wall(
+            {begin + width / 2.0f, room_size.y + ADDITIONAL_ROOM_HEIGHT},
+            {width, thickness});
+        spawn_wall({begin + width / 2.0f, -ADDITIONAL_ROOM_HEIGHT}, {width, thickness});
     }
+
+    const float height = room_size.y + ADDITIONAL_ROOM_HEIGHT * 2;
+    spawn_wall({0.0f, room_size.y / 2.0f}, {thickness, height});
+    spawn_wall({room_size.x, room_size.y / 2.0f}, {thickness, height});
 }
 
 void Level::draw_walls() {
-    auto view = registry.view<RectangleComponent, ColorComponent, PhysicsBodyComponent>();
+    PROFILE_SCOPE(ProfSection::draw_walls);
 
-    view.each([](auto, auto& rect, auto& color, auto& phys) {
+    walls.each([](auto, auto& rect, auto& color, auto& phys) {
         DrawRectanglePro(
             {phys.body->GetPosition().x, phys.body->GetPosition().y, rect.size.x, rect.size.y},
             rect.half_size,
@@ -239,7 +426,7 @@ void Level::draw_walls() {
 }
 
 void Level::spawn_balls(int amount) {
-    spdlog::debug("Attempting to spawn {} enemies", amount);
+    LOG_DEBUG(game, "Attempting to spawn {} enemies", amount);
     for (int i = 0; i < amount; i++) {
         // First we need to initialize an empty entity with no components.
         // This will make registry assign an unique entity id to it and return it.
@@ -248,7 +435,8 @@ void Level::spawn_balls(int amount) {
         // Now lets initialize and attach all required components to our entity id.
         float x = static_cast<float>(std::rand() % static_cast<int>(room_size.x));
         float y = room_size.y + ADDITIONAL_ROOM_HEIGHT / 2;
-        float size = static_cast<float>(std::rand() % 50) + 10.0f;
+        const int radius_range = static_cast<int>(MAX_BALL_RADIUS - MIN_BALL_RADIUS);
+        float size = static_cast<float>(std::rand() % radius_range) + MIN_BALL_RADIUS;
 
         auto& ball_comp = registry.emplace<BallComponent>(ball);
 
@@ -256,9 +444,6 @@ void Level::spawn_balls(int amount) {
         registry.emplace<HealthComponent>(ball, 1);
 
         auto& phys_body = registry.emplace<PhysicsBodyComponent>(ball);
-        registry.emplace<ColorComponent>(ball, BLUE);
-        phys_body.user_data->entity = ball;
-        phys_body.user_data->registry = &registry;
 
         b2CircleShape circle_shape;
         circle_shape.m_radius = size;
@@ -268,45 +453,101 @@ void Level::spawn_balls(int amount) {
         fixture_def.shape = &circle_shape;
         fixture_def.density = 1.0f;
         fixture_def.friction = 0.3f;
-        fixture_def.userData.pointer = reinterpret_cast<uintptr_t>(phys_body.user_data.get());
+        fixture_def.userData.pointer = to_user_data(ball);
 
         b2BodyDef body_def;
         body_def.type = b2_dynamicBody;
         const auto pos = Vector2{x, y};
         body_def.position.Set(pos.x, pos.y);
+        body_def.userData.pointer = to_user_data(ball);
 
-        phys_body.body = world.CreateBody(&body_def);
+        phys_body.body = shards.get_world_at(pos.x).CreateBody(&body_def);
         phys_body.body->CreateFixture(&fixture_def);
         // A lazy way to make balloon float upwards.
         // Does not have anything like weight, it probably affected by gravity
         // itself (e.g will move things upwards faster if gravity is higher.
         phys_body.body->SetGravityScale(-1.0f);
         // phys_body.body->SetAwake(true);
+
+        const bool is_explosive = std::rand() % EXPLOSIVE_CHANCE == 0;
+        if (is_explosive) {
+            registry.emplace<ExplosiveComponent>(ball, EXPLOSION_RADIUS);
+        }
+
+        // Same as with walls, this moves ball into its group, so it goes last
+        registry.emplace<ColorComponent>(ball, is_explosive ? ORANGE : BLUE);
     }
 
-    validate_physics();
+    sort_balls();
+    checker.check();
+}
+
+void Level::sort_balls() {
+    // Bodies are allocated in blocks in order of creation, while removals
+    // shuffle group's tail. Mostly sorted already, except for fresh spawns.
+    balls.sort<PhysicsBodyComponent>(
+        [](const PhysicsBodyComponent& lhs, const PhysicsBodyComponent& rhs) {
+            return std::less<b2Body*>()(lhs.body, rhs.body);
+        });
 }
 
 void Level::draw_balls() {
-    auto view = registry.view<BallComponent, ColorComponent, PhysicsBodyComponent>();
+    PROFILE_SCOPE(ProfSection::draw_balls);
+
+    const int segments = quality.circle_segments;
 
-    view.each([](auto, auto& ball, auto& color, auto& phys) {
-        DrawCircleV(
+    balls.each([segments](auto, auto& ball, auto& phys, auto& color, auto&) {
+        // Dormant balls (these have their bodies disabled) are off screen by
+        // definition. Checked here rather than with a view excluding them, so
+        // the group is walked linearly.
+        if (!phys.body->IsEnabled()) {
+            return;
+        }
+        DrawCircleSector(
             {phys.body->GetPosition().x, phys.body->GetPosition().y},
             ball.radius,
+            0.0f,
+            360.0f,
+            segments,
             color.color);
     });
 }
 
-void Level::damage_player() {
-    lifes--;
-    life_counter.set_text(fmt::format("Lifes: {}", lifes));
-    spdlog::info("Player HP has been decreased to {}", lifes);
-    if (lifes <= 0) {
-        gameover_screen.set_body_text(
-            fmt::format("Final Score: {}\nBalloons Popped: {}", score, enemies_killed));
-        is_gameover = true;
+void Level::apply_performance_settings() {
+    const auto& perf = app->perf;
+    perf_revision = app->perf_revision;
+
+    max_enemies = perf.max_balloons;
+    base_quality = {
+        perf.velocity_iterations,
+        perf.position_iterations,
+        perf.physics_rate,
+        CIRCLE_SEGMENTS,
+        1.0f,
+        perf.max_balloons};
+    quality = app->quality.apply(base_quality);
+
+    if (spawn_interval != perf.spawn_interval) {
+        spawn_interval = perf.spawn_interval;
+        spawn_timer = Timer(spawn_interval);
+        spawn_timer.start();
     }
+
+    wind.set_params(
+        perf.wind_min_interval,
+        perf.wind_max_interval,
+        perf.wind_min_power,
+        perf.wind_max_power);
+
+    LOG_DEBUG(
+        game,
+        "Applied performance settings: {} Hz physics, {}/{} iterations, up to {} "
+        "balloons every {} s",
+        perf.physics_rate,
+        perf.velocity_iterations,
+        perf.position_iterations,
+        perf.max_balloons,
+        perf.spawn_interval);
 }
 
 void Level::resume() {
@@ -319,55 +560,35 @@ void Level::exit_to_menu() {
 }
 
 void Level::cleanup_physics(entt::registry& reg, entt::entity e) {
-    spdlog::info("Deleting body component of entity {}", static_cast<uint32_t>(e));
+    LOG_RATE_LIMITED(
+        1.0f,
+        TRACE,
+        physics,
+        "Deleting body component of entity {}",
+        static_cast<uint32_t>(e));
     const auto& comp = reg.get<PhysicsBodyComponent>(e);
-    world.DestroyBody(comp.body);
-}
-
-void Level::validate_physics() {
-    auto body = world.GetBodyList();
-    std::vector<b2Body*> physics_bodies;
-    std::vector<b2Fixture*> fixtures;
-    std::vector<entt::entity> physics_entities;
-    std::vector<FixtureUserData*> physics_user_data;
-    while (body != nullptr) {
-        physics_bodies.push_back(body);
-        auto fixture = body->GetFixtureList();
-        fixtures.push_back(fixture);
-        auto data = reinterpret_cast<FixtureUserData*>(fixture->GetUserData().pointer);
-        physics_user_data.push_back(data);
-        physics_entities.push_back(data->entity);
-        body = body->GetNext();
-    }
-
-    std::vector<entt::entity> user_data_entities;
-    std::vector<entt::entity> alive_entities;
-    std::vector<b2Body*> physics_bodies_from_component;
-    std::vector<FixtureUserData*> user_data;
-    auto view = registry.view<PhysicsBodyComponent>();
-    for (auto e : view) {
-        alive_entities.push_back(e);
-        auto [body] = view.get(e);
-        user_data.push_back(body.user_data.get());
-        physics_bodies_from_component.push_back(body.body);
-        user_data_entities.push_back(body.user_data->entity);
-    }
-
-    for (auto e : alive_entities) {
-        ASSERT(registry.valid(e));
-        auto [body] = view.get(e);
-        ASSERT(registry.valid(body.user_data->entity));
-        ASSERT(std::find(physics_bodies.begin(), physics_bodies.end(), body.body) != physics_bodies.end());
-        ASSERT(std::find(physics_entities.begin(), physics_entities.end(), e) != physics_entities.end());
-    }
+    shards.destroy_body(comp.body);
 }
 
 // Level stuff
-Level::Level(App* app, SceneManager* p, Vector2 _room_size)
-    : parent(p)
+Level::Level(App* app, Vector2 room_size)
+    : Level(app, room_size, TraceSpan("Level::Level")) {}
+
+Level::Level(App* app, Vector2 _room_size, const TraceSpan&)
+    : frame_arena(FRAME_ARENA_SIZE)
+    , events(EVENTS_RESERVE)
+    , balls(registry.group<
+            BallComponent,
+            PhysicsBodyComponent,
+            ColorComponent,
+            HealthComponent>())
+    , walls(registry.group<RectangleComponent>(
+          entt::get<ColorComponent, PhysicsBodyComponent>))
     , room_size(_room_size)
-    , world({0.0f, 6.0f}) // Values are gravity, horizontal and vertical
-    , max_enemies(30) // TODO: rework this value to be based on Level's level.
+    // Values are gravity, horizontal and vertical
+    , shards(registry, {0.0f, 6.0f}, room_size.x, get_shards_amount(app, room_size.x))
+    // TODO: rework this value to be based on Level's level.
+    , max_enemies(app->perf.max_balloons)
     , enemies_left((std::rand() % (max_enemies - 10)) + 10)
     , enemies_killed(0)
     , score(0)
@@ -375,7 +596,8 @@ Level::Level(App* app, SceneManager* p, Vector2 _room_size)
     , score_counter(fmt::format("Score: {}", score), {10.0f, 10.0f})
     , life_counter(fmt::format("Lifes: {}", lifes), {10.0f, 40.0f})
     , kill_counter(fmt::format("Balloons Popped: {}", enemies_killed), {10.0f, 70.0f})
-    , spawn_timer(3.5f)
+    , spawn_interval(app->perf.spawn_interval)
+    , spawn_timer(spawn_interval)
     , gameover_screen(app, "Game Over", "", std::bind(&Level::exit_to_menu, this))
     , pause_screen(
         app,
@@ -385,7 +607,31 @@ Level::Level(App* app, SceneManager* p, Vector2 _room_size)
     , pause_button()
     , app(app)
     // TODO: set min/max timer and power values depending on level's difficulty
-    , wind(&world, 3.0f, 5.0f, 100.0f, 300.0f) {
+    , wind(
+          &shards,
+          &events,
+          app->perf.wind_min_interval,
+          app->perf.wind_max_interval,
+          app->perf.wind_min_power,
+          app->perf.wind_max_power)
+    , hit_tester(&shards)
+    , particles(MAX_PARTICLES)
+    , chain(CHAIN_BUDGET)
+    , sim_lod(registry, shards)
+    , checker(registry, shards) {
+    checker.set_level(parse_physics_check_level(
+        app->config->settings["physics_checks"].value_or(std::string("touched"))));
+    late_latch = app->config->settings["late_latch"].value_or(false);
+    sim_lod.set_enabled(app->config->settings["sim_lod"].value_or(true));
+    // Anything that may be hit from the screen must be simulated
+    sim_lod.set_margins(SPLASH_RADIUS, SPLASH_RADIUS * 2.0f);
+    sim_lod.set_room(
+        {0.0f,
+         -ADDITIONAL_ROOM_HEIGHT,
+         room_size.x,
+         room_size.y + ADDITIONAL_ROOM_HEIGHT * 2.0f});
+    shards.set_max_body_extent(MAX_BALL_RADIUS);
+    apply_performance_settings();
 
     GuiBuilder gb = GuiBuilder(app);
 
@@ -393,9 +639,15 @@ Level::Level(App* app, SceneManager* p, Vector2 _room_size)
 
     pause_button->set_pos({get_window_width() - 64.0f, 0.0f});
 
-    spawn_walls();
+    {
+        TRACE_SCOPE("spawn walls");
+        spawn_walls();
+    }
 
-    spawn_balls(enemies_left);
+    {
+        TRACE_SCOPE("spawn initial balls");
+        spawn_balls(enemies_left);
+    }
     spawn_timer.start();
 
     camera.target = {0.0f, 0.0f};
@@ -406,32 +658,78 @@ Level::Level(App* app, SceneManager* p, Vector2 _room_size)
     registry.on_destroy<PhysicsBodyComponent>().connect<&Level::cleanup_physics>(this);
 }
 
-Level::Level(App* app, SceneManager* p)
+Level::Level(App* app)
     : Level(app,
-          p,
           {static_cast<float>(get_window_width()), static_cast<float>(get_window_height())}) {
 }
 
 Level::~Level() {
+    TRACE_SCOPE("Level::~Level");
+    // There is no need to destroy bodies one by one, since the whole world is
+    // about to be dropped
+    registry.on_destroy<PhysicsBodyComponent>().disconnect<&Level::cleanup_physics>(this);
     delete pause_button;
+
+    const auto stats = particles.get_stats();
+    if (stats.emitted > 0 || stats.dropped > 0) {
+        spdlog::info(
+            "Particles: {} emitted, {} dropped, peak {} of {}",
+            stats.emitted,
+            stats.dropped,
+            stats.peak,
+            particles.get_capacity());
+    }
+
+    const auto& chain_stats = chain.get_stats();
+    if (chain_stats.detonated > 0) {
+        spdlog::info(
+            "Chain reactions: {} explosions, up to {} pending, {} frames deferred",
+            chain_stats.detonated,
+            chain_stats.peak_pending,
+            chain_stats.deferred_frames);
+    }
+
+    // Bulk of teardown, done explicitly so the span above covers it. Members'
+    // destructors would only run after the span has ended.
+    registry.clear();
+    shards.clear();
 }
 
 void Level::update(float dt) {
+    const auto update_start = std::chrono::steady_clock::now();
+
+    // Everything allocated from arena during previous frame is no longer needed
+    frame_arena.reset();
+
     if (must_close) {
-        parent->set_current_scene(new MainMenu(app, parent));
+        app->scenes->open_main_menu();
         return;
     }
 
     if (is_gameover) {
+        PROFILE_SCOPE(ProfSection::ui);
         gameover_screen.update();
     }
     else if (is_paused) {
+        PROFILE_SCOPE(ProfSection::ui);
         pause_screen.update();
     }
     else {
         pause_button->update();
         if (pause_button->is_clicked()) {
             is_paused = true;
+            // Else first slice after resume would span the whole pause
+            slice_input.reset();
+        }
+
+        if (IsKeyPressed(KEY_Q)) {
+            is_slicing = !is_slicing;
+            slice_input.reset();
+            spdlog::info("Slicing mode is {}", is_slicing ? "enabled" : "disabled");
+        }
+
+        if (IsKeyPressed(KEY_F)) {
+            is_debug_draw = !is_debug_draw;
         }
 
         // Temporary stuff for debug purposes.
@@ -452,23 +750,62 @@ void Level::update(float dt) {
             camera.target = {0.0f, 0.0f};
         }
 
+        checker.update();
+
+        if (perf_revision != app->perf_revision) {
+            apply_performance_settings();
+        }
+        app->quality.update(work_ms, physics_ms, 1000.0f / app->pacer.get_budget_fps());
+        quality = app->quality.apply(base_quality);
+        phys_time = 1.0f / quality.physics_rate;
+
         // update_collisions_tree(dt);
 
         // I'm not 100% sure what this does. But its been done like that in
         // raylib's examples, so I guess its a correct approach?
         accumulator += dt;
-        while (accumulator >= phys_time) {
-            accumulator -= phys_time;
-            update_collisions_tree(phys_time);
+        {
+            PROFILE_SCOPE(ProfSection::physics);
+            const auto physics_start = std::chrono::steady_clock::now();
+            int steps = 0;
+            while (accumulator >= phys_time) {
+                accumulator -= phys_time;
+                update_collisions_tree(phys_time);
+                steps++;
+            }
+            {
+                PROFILE_SCOPE(ProfSection::sim_lod);
+                const float stepped = static_cast<float>(steps) * phys_time;
+                sim_lod.update(get_view(), stepped, phys_time);
+            }
+            physics_ms = elapsed_ms(physics_start);
+        }
+        detect_escaped_balls();
+
+        particles.set_budget(quality.particle_budget);
+        {
+            PROFILE_SCOPE(ProfSection::particles);
+            particles.update(dt, *app->jobs);
         }
 
         wind.update(dt);
 
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        if (!late_latch) {
             process_mouse_collisions(GetScreenToWorld2D(GetMousePosition(), camera));
-        };
+        }
 
-        if (enemies_left < max_enemies) {
+        {
+            PROFILE_SCOPE(ProfSection::chain);
+            chain.update(hit_tester, events);
+        }
+
+        // Before spawning, so it sees balls that have just left the level
+        process_events();
+
+        // Governor may lower spawn cap, but never raise it
+        const int spawn_cap = quality.max_enemies;
+        if (enemies_left < spawn_cap) {
+            PROFILE_SCOPE(ProfSection::spawn);
             if (spawn_timer.tick(dt)) {
                 spawn_timer.start();
 
@@ -476,7 +813,7 @@ void Level::update(float dt) {
                 // Thus I've replaced it with garbage below, for now
                 // int spawn_amount = (std::rand() % (max_enemies - enemies_left - 1)) + 1;
                 int spawn_amount;
-                int spawn_diff = max_enemies - enemies_left;
+                int spawn_diff = spawn_cap - enemies_left;
                 if (spawn_diff > 1) {
                     spawn_amount = (std::rand() % spawn_diff - 1) + 1;
                 }
@@ -489,23 +826,69 @@ void Level::update(float dt) {
             }
         }
     }
+
+    work_ms = elapsed_ms(update_start);
 }
 
 void Level::draw() {
+    const auto draw_start = std::chrono::steady_clock::now();
+
+    // Spawning and everything else has already happened, thus hits are tested
+    // against exactly what is about to be shown
+    if (late_latch && !is_paused && !is_gameover) {
+        process_mouse_collisions(GetScreenToWorld2D(GetMousePosition(), camera));
+        process_events();
+    }
+
     BeginMode2D(camera);
     draw_walls();
     draw_balls();
+    {
+        PROFILE_SCOPE(ProfSection::particles);
+        particles.draw();
+    }
+    if (is_slicing) {
+        draw_slices();
+    }
+    if (is_debug_draw) {
+        debug_draw.draw_world(shards, get_view());
+    }
     EndMode2D();
 
-    score_counter.draw();
-    life_counter.draw();
-    kill_counter.draw();
-    pause_button->draw();
+    {
+        PROFILE_SCOPE(ProfSection::hud);
+        score_counter.draw();
+        life_counter.draw();
+        kill_counter.draw();
+        pause_button->draw();
+        if (is_debug_draw) {
+            debug_draw.draw_stats({10.0f, 100.0f});
+            const auto& lod = sim_lod.get_stats();
+            DrawText(
+                fmt::format(
+                    "dormant {}  promotions {}  demotions {}",
+                    lod.dormant,
+                    lod.promotions,
+                    lod.demotions)
+                    .c_str(),
+                10,
+                124,
+                10,
+                YELLOW);
+        }
+    }
 
+    PROFILE_SCOPE(ProfSection::ui);
     if (is_gameover) {
         gameover_screen.draw();
     }
     else if (is_paused) {
         pause_screen.draw();
     }
+
+    work_ms += elapsed_ms(draw_start);
+}
+
+bool Level::is_idle() const {
+    return is_paused || is_gameover;
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "arena.hpp"
 #include "box2d/b2_world.h"
+#include "chain_reaction.hpp"
 #include "components.hpp"
 #include "engine/core.hpp"
 #include "engine/ui.hpp"
@@ -8,16 +10,30 @@
 #include "box2d/box2d.h"
 #include "entt/entity/registry.hpp"
 #include "event_screens.hpp"
+#include "events.hpp"
+#include "hit_test.hpp"
+#include "idle.hpp"
+#include "particles.hpp"
+#include "physics_checker.hpp"
+#include "physics_debug.hpp"
+#include "physics_shards.hpp"
+#include "quality.hpp"
+#include "sim_lod.hpp"
+#include "slicing.hpp"
+#include "trace.hpp"
 #include "raylib.h"
 #include <optional>
 #include <string>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 class App;
 
 class Wind {
 private:
-    b2World* world;
+    PhysicsShards* shards;
+    GameplayEvents* events;
 
     float min_timer_length;
     float max_timer_length;
@@ -30,33 +46,72 @@ private:
 
 public:
     Wind(
-        b2World* world,
+        PhysicsShards* shards,
+        GameplayEvents* events,
         float min_timer_length,
         float max_timer_length,
         float min_power,
         float max_power);
 
+    // New intervals take effect after the current one runs out
+    void set_params(
+        float min_timer_length, float max_timer_length, float min_power, float max_power);
+
     void update(float dt);
 };
 
-class Level : public Scene {
+class Level : public Scene, public IdleReporter {
+    friend class Benchmark;
+
 private:
-    SceneManager* parent;
+    // Components that are always used together are owned by groups, thus are
+    // kept packed in the same order, and systems iterate them as parallel
+    // arrays without any sparse set lookups
+    using BallGroup = decltype(std::declval<entt::registry&>().group<
+                               BallComponent,
+                               PhysicsBodyComponent,
+                               ColorComponent,
+                               HealthComponent>());
+    // Physics and color components are owned by balls, thus walls only own
+    // their rectangles
+    using WallGroup = decltype(std::declval<entt::registry&>().group<RectangleComponent>(
+        entt::get<ColorComponent, PhysicsBodyComponent>));
 
     // Specifies if Level must be closed
     bool must_close = false;
 
+    // Storage for transient per-frame containers. Reset on each update()
+    LinearArena frame_arena;
+
+    // Everything that happened during the frame. Drained by process_events()
+    GameplayEvents events;
+
     // Level's registry that will hold our entities.
     entt::registry registry;
+    BallGroup balls;
+    WallGroup walls;
 
     Vector2 room_size;
 
-    b2World world;
+    // Split into vertical strips, if physics_shards setting asks for it
+    PhysicsShards shards;
 
     // Collision stuff
     float accumulator = 0;
     float phys_time = 1 / 60.0f;
 
+    // Time spent on last frame's update and draw, and its physics part, in ms.
+    // Reported to quality governor.
+    float work_ms = 0.0f;
+    float physics_ms = 0.0f;
+
+    // Settings from [performance] and what quality governor has left of them
+    // for the current frame
+    QualitySettings base_quality;
+    QualitySettings quality;
+    // App's perf_revision these have been taken from
+    unsigned perf_revision;
+
     Camera2D camera;
 
     // Max enemies amount
@@ -73,6 +128,7 @@ private:
     Label kill_counter;
 
     // Balls spawn cooldown
+    float spawn_interval;
     Timer spawn_timer;
 
     bool is_gameover = false;
@@ -85,28 +141,75 @@ private:
 
     Wind wind;
 
+    HitTester hit_tester;
+
+    // Confetti of popped balloons
+    ParticleSystem particles;
+
+    // Explosions of popped explosive balloons, spread over frames
+    ChainReaction chain;
+
+    // If enabled, holding left mouse button (or touching the screen) slices
+    // through everything pointer moves over, instead of single clicks
+    bool is_slicing = false;
+    SliceInput slice_input;
+
+    // If enabled, clicks are resolved right before drawing, against the very
+    // state that is about to be drawn, instead of in the middle of update
+    bool late_latch = false;
+
+    // Toggled with F. Draws what box2d sees on top of the level.
+    bool is_debug_draw = false;
+    PhysicsDebugDraw debug_draw;
+
+    // Must be declared after registry and world, since it refers to both
+    SimulationLod sim_lod;
+
+    // Must be declared after registry and world, since it refers to both
+    PhysicsChecker checker;
+
     // Collision tree shenanigans
     void update_collisions_tree(float dt);
+    // Part of the world that is currently on screen
+    Rectangle get_view() const;
     void process_mouse_collisions(Vector2 mouse_pos);
-
+    void draw_slices();
+    // Queue a hit for each ball among targets
+    void damage_entities(const std::vector<entt::entity>& targets, int dmg);
+    // Queue balls that have flown above the screen
+    void detect_escaped_balls();
+    // Apply queued events in batch: damage, scoring, audio, player's lifes,
+    // HUD and, at last, removal of popped and escaped balls
+    void process_events();
+
+    void spawn_wall(Vector2 pos, Vector2 size);
     void spawn_walls();
     void draw_walls();
 
     void spawn_balls(int amount);
+    // Order balls by address of their bodies, so iterating them walks bodies
+    // sequentially too
+    void sort_balls();
     void draw_balls();
 
-    void damage_player();
+    // Pick up changes of app's performance settings
+    void apply_performance_settings();
+
     void resume();
     void exit_to_menu();
     void cleanup_physics(entt::registry& reg, entt::entity e);
 
-    void validate_physics();
+    // Does the actual construction. Span lives till this returns, thus covers
+    // building of members too, not just constructor's body.
+    Level(App* app, Vector2 room_size, const TraceSpan&);
 
 public:
-    Level(App* app, SceneManager* p, Vector2 room_size);
-    Level(App* app, SceneManager* p);
+    Level(App* app, Vector2 room_size);
+    Level(App* app);
     ~Level();
 
     void update(float dt) override;
     void draw() override;
+    // Level is only idle while paused or over
+    bool is_idle() const override;
 };
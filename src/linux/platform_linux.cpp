@@ -1,5 +1,7 @@
 #include "platform_linux.hpp"
 
+#include <sys/resource.h>
+
 std::string PlatformLinux::get_resource_dir() {
     return "./Assets/";
 }
@@ -15,3 +17,13 @@ std::string PlatformLinux::get_sounds_dir() {
 std::string PlatformLinux::get_settings_dir() {
     return "./";
 }
+
+double PlatformLinux::get_cpu_time() {
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
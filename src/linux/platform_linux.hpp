@@ -8,4 +8,5 @@ public:
     std::string get_sprites_dir() override;
     std::string get_sounds_dir() override;
     std::string get_settings_dir() override;
+    double get_cpu_time() override;
 };
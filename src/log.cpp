@@ -0,0 +1,97 @@
+#include "log.hpp"
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+
+static constexpr std::size_t SUBSYSTEMS = static_cast<std::size_t>(LogSubsystem::count);
+// Messages that can wait in queue. On overflow, the oldest ones get dropped, so
+// game thread never blocks on logging.
+static constexpr std::size_t QUEUE_SIZE = 8192;
+
+static constexpr const char* LOGGER_NAMES[SUBSYSTEMS] = {
+    "game",
+    "physics",
+    "input",
+    "wind",
+    "ui",
+};
+
+static std::array<std::shared_ptr<spdlog::logger>, SUBSYSTEMS> loggers;
+// Set from command line. Levels from settings can't be less verbose than that.
+static spdlog::level::level_enum forced_level = spdlog::level::off;
+
+void init_logging() {
+    spdlog::init_thread_pool(QUEUE_SIZE, 1);
+    auto sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+
+    for (std::size_t i = 0; i < SUBSYSTEMS; i++) {
+        loggers[i] = std::make_shared<spdlog::async_logger>(
+            LOGGER_NAMES[i],
+            sink,
+            spdlog::thread_pool(),
+            spdlog::async_overflow_policy::overrun_oldest);
+        loggers[i]->flush_on(spdlog::level::warn);
+        spdlog::register_logger(loggers[i]);
+    }
+
+    spdlog::set_default_logger(loggers[static_cast<std::size_t>(LogSubsystem::game)]);
+}
+
+void shutdown_logging() {
+    spdlog::shutdown();
+    loggers.fill(nullptr);
+}
+
+spdlog::logger* get_logger(LogSubsystem subsystem) {
+    auto& logger = loggers[static_cast<std::size_t>(subsystem)];
+    if (logger == nullptr) {
+        return spdlog::default_logger_raw();
+    }
+    return logger.get();
+}
+
+const char* get_logger_name(LogSubsystem subsystem) {
+    return LOGGER_NAMES[static_cast<std::size_t>(subsystem)];
+}
+
+void set_log_level(spdlog::level::level_enum level) {
+    for (std::size_t i = 0; i < SUBSYSTEMS; i++) {
+        set_log_level(static_cast<LogSubsystem>(i), level);
+    }
+}
+
+void set_log_level(LogSubsystem subsystem, spdlog::level::level_enum level) {
+    get_logger(subsystem)->set_level(std::min(level, forced_level));
+}
+
+void force_log_level(spdlog::level::level_enum level) {
+    forced_level = level;
+    set_log_level(level);
+}
+
+LogRateLimiter::LogRateLimiter(float seconds)
+    : interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<float>(seconds)))
+    , next()
+    , suppressed(0) {}
+
+bool LogRateLimiter::allow() {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next) {
+        suppressed++;
+        return false;
+    }
+
+    next = now + interval;
+    return true;
+}
+
+std::size_t LogRateLimiter::take_suppressed() {
+    const auto amount = suppressed;
+    suppressed = 0;
+    return amount;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+// Logging on top of spdlog. Each subsystem has its own logger, thus its own
+// level. All of these are asynchronous, so formatting and console output happen
+// on logging thread instead of the game's one.
+//
+// Messages below SPDLOG_ACTIVE_LEVEL (set by CMake depending on build type) are
+// stripped at compile time, so trace/debug messages in hot paths cost nothing
+// in release builds.
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class LogSubsystem : std::uint8_t {
+    game,
+    physics,
+    input,
+    wind,
+    ui,
+    count
+};
+
+// Create loggers and make "game" the default one. Must be called before any
+// other logging function.
+void init_logging();
+// Flush pending messages and stop logging thread
+void shutdown_logging();
+
+spdlog::logger* get_logger(LogSubsystem subsystem);
+const char* get_logger_name(LogSubsystem subsystem);
+
+// Set level of all subsystems
+void set_log_level(spdlog::level::level_enum level);
+void set_log_level(LogSubsystem subsystem, spdlog::level::level_enum level);
+// Set level of all subsystems and don't let later calls make logging less
+// verbose than that (used by --debug, so settings can't override it)
+void force_log_level(spdlog::level::level_enum level);
+
+// Lets through up to one message per interval and counts the rest
+class LogRateLimiter {
+private:
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point next;
+    std::size_t suppressed;
+
+public:
+    LogRateLimiter(float seconds);
+
+    bool allow();
+    // Amount of messages suppressed since previous allowed one
+    std::size_t take_suppressed();
+};
+
+#define LOG_TRACE(subsystem, ...)                                                        \
+    SPDLOG_LOGGER_TRACE(get_logger(LogSubsystem::subsystem), __VA_ARGS__)
+#define LOG_DEBUG(subsystem, ...)                                                        \
+    SPDLOG_LOGGER_DEBUG(get_logger(LogSubsystem::subsystem), __VA_ARGS__)
+#define LOG_INFO(subsystem, ...)                                                         \
+    SPDLOG_LOGGER_INFO(get_logger(LogSubsystem::subsystem), __VA_ARGS__)
+#define LOG_WARN(subsystem, ...)                                                         \
+    SPDLOG_LOGGER_WARN(get_logger(LogSubsystem::subsystem), __VA_ARGS__)
+#define LOG_ERROR(subsystem, ...)                                                        \
+    SPDLOG_LOGGER_ERROR(get_logger(LogSubsystem::subsystem), __VA_ARGS__)
+
+// Same as above, but logs at most once per `seconds` per call site. Amount of
+// suppressed messages gets reported together with the next allowed one. Meant
+// for per-entity messages in hot loops, which would flood the log otherwise.
+// Disabled levels don't touch the limiter (nor the clock) at all.
+#define LOG_RATE_LIMITED(seconds, lvl, subsystem, ...)                                   \
+    do {                                                                                 \
+        static LogRateLimiter log_limiter_(seconds);                                     \
+        if (SPDLOG_LEVEL_##lvl >= SPDLOG_ACTIVE_LEVEL                                    \
+            && get_logger(LogSubsystem::subsystem)                                       \
+                   ->should_log(                                                         \
+                       static_cast<spdlog::level::level_enum>(SPDLOG_LEVEL_##lvl))       \
+            && log_limiter_.allow()) {                                                   \
+            LOG_##lvl(subsystem, __VA_ARGS__);                                           \
+            const auto log_suppressed_ = log_limiter_.take_suppressed();                 \
+            if (log_suppressed_ > 0) {                                                   \
+                LOG_##lvl(                                                               \
+                    subsystem, "({} similar messages suppressed)", log_suppressed_);     \
+            }                                                                            \
+        }                                                                                \
+    } while (false)
@@ -5,6 +5,8 @@
 
 #include <fmt/format.h>
 
+#include <sys/resource.h>
+
 std::string PlatformMacos::get_resource_dir() {
     CFBundleRef bundle = CFBundleGetMainBundle();
     CFURLRef resource_dir = CFBundleCopyResourcesDirectoryURL(bundle);
@@ -29,3 +31,13 @@ std::string PlatformMacos::get_sounds_dir() {
 std::string PlatformMacos::get_settings_dir() {
     return get_resource_dir();
 }
+
+double PlatformMacos::get_cpu_time() {
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
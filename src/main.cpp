@@ -1,20 +1,54 @@
+#include "alloc_tracker.hpp"
 #include "app.hpp"
+#include "benchmark.hpp"
+#include "latency.hpp"
+#include "log.hpp"
+#include "trace.hpp"
 
-#include <spdlog/spdlog.h>
+#include <cstring>
 
 int main(int argc, char* const* argv) {
-    // Processing launch arguments.
-    // For now there is just one - to toggle on debug messages.
+    init_logging();
+
+    // Processing launch arguments:
+    // --debug - toggle on debug messages
+    // --trace <file> - write chrome trace of startup and transitions into file
+    // --benchmark - run stress scenarios instead of the game and log results
+    bool benchmark = false;
     if (argc > 1) {
         for (int i = 1; i < argc; i++) {
             if (std::strcmp(argv[i], "--debug") == 0) {
-                spdlog::set_level(spdlog::level::debug);
+                force_log_level(spdlog::level::debug);
+            }
+            else if (std::strcmp(argv[i], "--benchmark") == 0) {
+                benchmark = true;
             }
+            else if (std::strcmp(argv[i], "--trace") == 0) {
+                if (i + 1 < argc) {
+                    Tracer::get().start(argv[++i]);
+                }
+                else {
+                    spdlog::error("--trace requires path to output file");
+                }
+            }
+        }
+    }
+
+    {
+        // Scoped, so App's teardown gets into trace too
+        App app;
+        if (benchmark) {
+            Benchmark(&app).run();
+        }
+        else {
+            app.run();
         }
     }
 
-    App app;
-    app.run();
+    AllocTracker::report();
+    InputLatency::get().report();
+    Tracer::get().stop();
+    shutdown_logging();
 
     return 0;
 }
@@ -3,18 +3,26 @@
 #include "app.hpp"
 #include "common.hpp"
 #include "level.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
+#include "scene_cache.hpp"
 #include "spdlog/spdlog.h"
 
 #include <engine/ui.hpp>
 #include <engine/settings.hpp>
 
 #include <raylib.h>
+#include <cstddef>
 #include <functional>
 
+static constexpr std::size_t PERFORMANCE_OPTIONS =
+    static_cast<std::size_t>(PerformanceOption::count);
+// Vertical distance between performance rows, enough to fit a text button
+static constexpr float PERFORMANCE_ROW_HEIGHT = 70.0f;
+
 // Title Screen
-TitleScreen::TitleScreen(App* app, SceneManager* p)
-    : parent(p)
-    , timer(Timer(2.0f))
+TitleScreen::TitleScreen(App* app)
+    : timer(Timer(2.0f))
     , greeter("This game has been made with raylib", {get_window_width() / 2.0f, get_window_height() / 2.0f})
     , app(app) {
 
@@ -24,7 +32,7 @@ TitleScreen::TitleScreen(App* app, SceneManager* p)
 
 void TitleScreen::update(float dt) {
     if (timer.tick(dt)) {
-        parent->set_current_scene(new MainMenu(app, parent));
+        app->scenes->open_main_menu();
     }
 }
 
@@ -32,161 +40,239 @@ void TitleScreen::draw() {
     greeter.draw();
 }
 
-// Settings Screen
-class SettingsScreen : public Scene {
-private:
-    SceneManager* parent;
-
-    // It may be done without this thing, but will do for now
-    toml::table current_settings;
-
-    Label title;
-    Label unsaved_changes_msg;
-    bool settings_changed;
+// Timer doesn't need full frame rate to fire in time
+bool TitleScreen::is_idle() const {
+    return true;
+}
 
-    Button* save_button;
-    Button* exit_button;
+// Settings Screen
+SettingsScreen::SettingsScreen(App* app)
+    : current_settings(app->config->settings) // this should get copied
+    , title("Settings", {get_window_width() / 2.0f, 30.0f})
+    , unsaved_changes_msg(
+          "Settings changed. Press save to apply!",
+          {get_window_width() / 2.0f, 60.0f})
+    , settings_changed(false)
+    , show_fps_title("Show FPS:", {30.0f, 100.0f})
+    , fullscreen_title("Fullscreen:", {30.0f, 150.0f})
+    , show_profiler_title("Show Profiler:", {30.0f, 200.0f})
+    , pacing_title("Frame Pacing:", {30.0f, 250.0f})
+    , pacing_value("", {200.0f, 250.0f})
+    , pacing_mode(app->pacer.get_mode())
+    , performance_title("Performance", {get_window_width() / 2.0f + 20.0f, 100.0f})
+    , performance(app->perf)
+    , app(app) {
 
-    Label show_fps_title;
-    Checkbox* fps_cb;
+    GuiBuilder b(app);
+    save_button = b.make_text_button("Save");
+    exit_button = b.make_close_button();
+
+    fps_cb = b.make_checkbox(
+        app->config->settings["show_fps"].value_exact<bool>().value());
+    fullscreen_cb = b.make_checkbox(
+        app->config->settings["fullscreen"].value_exact<bool>().value());
+    profiler_cb = b.make_checkbox(app->config->settings["show_profiler"].value_or(false));
+    pacing_button = b.make_text_button("Change");
+    pacing_value.set_text(get_pacing_mode_name(pacing_mode));
+
+    title.center();
+    unsaved_changes_msg.center();
+
+    save_button->set_pos(
+        {get_window_width() / 2.0f - save_button->get_rect().width / 2.0f,
+         get_window_height() - 100.0f});
+    exit_button->set_pos({static_cast<float>(get_window_width() - (30 + 64)), 30.0f});
+
+    const float cb_x = 200.0f;
+    fps_cb->set_pos({cb_x, 100.0f});
+    fullscreen_cb->set_pos({cb_x, 150.0f});
+    profiler_cb->set_pos({cb_x, 200.0f});
+    pacing_button->set_pos({cb_x + 140.0f, 240.0f});
+
+    const float perf_x = get_window_width() / 2.0f + 20.0f;
+    for (std::size_t i = 0; i < PERFORMANCE_OPTIONS; i++) {
+        const auto option = static_cast<PerformanceOption>(i);
+        const float y = 150.0f + PERFORMANCE_ROW_HEIGHT * static_cast<float>(i);
+
+        performance_titles.emplace_back(
+            get_performance_option_title(option), Vector2{perf_x, y});
+        performance_values.emplace_back(
+            get_performance_option_value(performance, option), Vector2{perf_x + 180.0f, y});
+        performance_buttons.push_back(b.make_text_button("Change"));
+        performance_buttons.back()->set_pos({perf_x + 300.0f, y - 10.0f});
+    }
+}
 
-    Label fullscreen_title;
-    Checkbox* fullscreen_cb;
+SettingsScreen::~SettingsScreen() {
+    delete fps_cb;
+    delete fullscreen_cb;
+    delete profiler_cb;
+    delete pacing_button;
+    for (auto button : performance_buttons) {
+        delete button;
+    }
+    delete save_button;
+    delete exit_button;
+}
 
-    App* app;
+bool SettingsScreen::has_unsaved_changes() {
+    return (
+        fps_cb->get_toggle() != app->config->settings["show_fps"].value_or(false) ||
+        fullscreen_cb->get_toggle() != app->config->settings["fullscreen"].value_or(false) ||
+        profiler_cb->get_toggle() != app->config->settings["show_profiler"].value_or(false) ||
+        pacing_mode != app->pacer.get_mode() || performance != app->perf);
+}
 
-    void exit_to_menu() {
-        spdlog::info("Switching to main menu");
-        exit_button->reset_state();
-        parent->set_current_scene(new MainMenu(app, parent));
+void SettingsScreen::exit_to_menu() {
+    spdlog::info("Switching to main menu");
+    exit_button->reset_state();
+    // Cached screen must not keep toggles that haven't been saved
+    if (has_unsaved_changes()) {
+        app->scenes->discard_settings();
     }
+    app->scenes->open_main_menu();
+}
 
-    void save_settings() {
-        save_button->reset_state();
-        if (!settings_changed) return;
+void SettingsScreen::save_settings() {
+    save_button->reset_state();
+    if (!settings_changed) return;
 
-        current_settings.insert_or_assign("show_fps", fps_cb->get_toggle());
-        current_settings.insert_or_assign("fullscreen", fullscreen_cb->get_toggle());
+    TRACE_SCOPE("SettingsScreen::save_settings");
 
-        spdlog::info("Attempting to apply new settings");
-        settings_changed = false;
+    current_settings.insert_or_assign("show_fps", fps_cb->get_toggle());
+    current_settings.insert_or_assign("fullscreen", fullscreen_cb->get_toggle());
+    current_settings.insert_or_assign("show_profiler", profiler_cb->get_toggle());
+    current_settings.insert_or_assign("frame_pacing", get_pacing_mode_name(pacing_mode));
+    // Wind tunables have no controls, thus these are written back as loaded
+    current_settings.insert_or_assign("performance", make_performance_table(performance));
 
-        if (current_settings["show_fps"].value_exact<bool>().value()) {
-            if (app->window.sc_mgr.nodes.count("fps_counter") == 0) {
-                app->window.sc_mgr.nodes["fps_counter"] = new FrameCounter({4.0f, 4.0f});
-            }
-        }
-        else {
-            app->window.sc_mgr.nodes.erase("fps_counter");
+    spdlog::info("Attempting to apply new settings");
+    settings_changed = false;
+
+    if (current_settings["show_fps"].value_exact<bool>().value()) {
+        if (app->window.sc_mgr.nodes.count("fps_counter") == 0) {
+            app->window.sc_mgr.nodes["fps_counter"] = new FrameCounter({4.0f, 4.0f});
         }
+    }
+    else {
+        app->window.sc_mgr.nodes.erase("fps_counter");
+    }
 
-        if (current_settings["fullscreen"].value_exact<bool>().value()) {
-            if (!IsWindowFullscreen()) {
-                const int current_screen = GetCurrentMonitor();
-                const int screen_width = GetMonitorWidth(current_screen);
-                const int screen_height = GetMonitorHeight(current_screen);
+    app->set_profiler_visible(current_settings["show_profiler"].value_or(false));
 
-                ToggleFullscreen();
-                SetWindowSize(screen_width, screen_height);
-            };
-        }
-        else {
-            if (IsWindowFullscreen()) {
-                SetWindowSize(
-                    current_settings["resolution"][0].value_or(1280),
-                    current_settings["resolution"][1].value_or(720));
-                ToggleFullscreen();
-            };
-        }
+    bool window_resized = false;
+    if (current_settings["fullscreen"].value_exact<bool>().value()) {
+        if (!IsWindowFullscreen()) {
+            const int current_screen = GetCurrentMonitor();
+            const int screen_width = GetMonitorWidth(current_screen);
+            const int screen_height = GetMonitorHeight(current_screen);
+
+            ToggleFullscreen();
+            SetWindowSize(screen_width, screen_height);
+            window_resized = true;
+        };
+    }
+    else {
+        if (IsWindowFullscreen()) {
+            SetWindowSize(
+                current_settings["resolution"][0].value_or(1280),
+                current_settings["resolution"][1].value_or(720));
+            ToggleFullscreen();
+            window_resized = true;
+        };
+    }
 
-        app->config->settings = current_settings;
-        app->config->save();
+    app->config->settings = current_settings;
+    app->config->save();
+    app->apply_frame_pacing();
+    app->apply_performance_settings();
 
+    // Cached scenes are laid out based on window size, thus all of these
+    // (including this one) must be rebuilt on resize.
+    if (window_resized) {
         spdlog::info("Resetting settings screen");
-        parent->set_current_scene(new SettingsScreen(app, parent));
-    }
-
-public:
-    SettingsScreen(App* app, SceneManager* p)
-        : parent(p)
-        , current_settings(app->config->settings) // this should get copied
-        , title("Settings", {get_window_width() / 2.0f, 30.0f})
-        , unsaved_changes_msg(
-              "Settings changed. Press save to apply!",
-              {get_window_width() / 2.0f, 60.0f})
-        , settings_changed(false)
-        , show_fps_title("Show FPS:", {30.0f, 100.0f})
-        , fullscreen_title("Fullscreen:", {30.0f, 150.0f})
-        , app(app) {
-
-        GuiBuilder b(app);
-        save_button = b.make_text_button("Save");
-        exit_button = b.make_close_button();
-
-        fps_cb = b.make_checkbox(
-            app->config->settings["show_fps"].value_exact<bool>().value());
-        fullscreen_cb = b.make_checkbox(
-            app->config->settings["fullscreen"].value_exact<bool>().value());
-
-        title.center();
-        unsaved_changes_msg.center();
-
-        save_button->set_pos(
-            {get_window_width() / 2.0f - save_button->get_rect().width / 2.0f,
-             get_window_height() - 100.0f});
-        exit_button->set_pos({static_cast<float>(get_window_width() - (30 + 64)), 30.0f});
-
-        const float cb_x = 200.0f;
-        fps_cb->set_pos({cb_x, 100.0f});
-        fullscreen_cb->set_pos({cb_x, 150.0f});
-    }
-
-    ~SettingsScreen() {
-        delete fps_cb;
-        delete fullscreen_cb;
-        delete exit_button;
-    }
-
-    void update(float) override {
-        save_button->update();
-        exit_button->update();
-        fps_cb->update();
-        fullscreen_cb->update();
-
-        if (exit_button->is_clicked()) {
-            exit_to_menu();
-            return;
-        }
+        app->scenes->invalidate();
+        app->scenes->open_settings();
+    }
+}
 
-        if (save_button->is_clicked()) {
-            save_settings();
-            return;
-        }
+void SettingsScreen::update(float) {
+    save_button->update();
+    exit_button->update();
+    fps_cb->update();
+    fullscreen_cb->update();
+    profiler_cb->update();
+    pacing_button->update();
+
+    if (pacing_button->is_clicked()) {
+        pacing_button->reset_state();
+        pacing_mode = static_cast<PacingMode>(
+            (static_cast<int>(pacing_mode) + 1) % static_cast<int>(PacingMode::count));
+        pacing_value.set_text(get_pacing_mode_name(pacing_mode));
+    }
 
-        if (fps_cb->is_clicked() || fullscreen_cb->is_clicked()) {
-            settings_changed = true;
-        }
-        else {
-            settings_changed = false;
+    for (std::size_t i = 0; i < PERFORMANCE_OPTIONS; i++) {
+        performance_buttons[i]->update();
+        if (performance_buttons[i]->is_clicked()) {
+            performance_buttons[i]->reset_state();
+            const auto option = static_cast<PerformanceOption>(i);
+            cycle_performance_option(performance, option);
+            performance_values[i].set_text(get_performance_option_value(performance, option));
         }
     }
 
-    void draw() override {
-        title.draw();
+    if (exit_button->is_clicked()) {
+        exit_to_menu();
+        return;
+    }
+
+    if (save_button->is_clicked()) {
+        save_settings();
+        return;
+    }
 
-        show_fps_title.draw();
-        fullscreen_title.draw();
+    if (fps_cb->is_clicked() || fullscreen_cb->is_clicked() || profiler_cb->is_clicked() ||
+        pacing_mode != app->pacer.get_mode() || performance != app->perf) {
+        settings_changed = true;
+    }
+    else {
+        settings_changed = false;
+    }
+}
 
-        save_button->draw();
-        exit_button->draw();
-        fps_cb->draw();
-        fullscreen_cb->draw();
+void SettingsScreen::draw() {
+    PROFILE_SCOPE(ProfSection::ui);
+
+    title.draw();
+
+    show_fps_title.draw();
+    fullscreen_title.draw();
+    show_profiler_title.draw();
+    pacing_title.draw();
+    pacing_value.draw();
+
+    save_button->draw();
+    exit_button->draw();
+    fps_cb->draw();
+    fullscreen_cb->draw();
+    profiler_cb->draw();
+    pacing_button->draw();
+
+    performance_title.draw();
+    for (std::size_t i = 0; i < PERFORMANCE_OPTIONS; i++) {
+        performance_titles[i].draw();
+        performance_values[i].draw();
+        performance_buttons[i]->draw();
+    }
 
-        if (settings_changed) {
-            unsaved_changes_msg.draw();
-        }
+    if (settings_changed) {
+        unsaved_changes_msg.draw();
     }
-};
+}
+
+bool SettingsScreen::is_idle() const {
+    return true;
+}
 
 // Main menu
 void MainMenu::call_exit() {
@@ -196,17 +282,16 @@ void MainMenu::call_exit() {
 
 void MainMenu::new_game() {
     spdlog::info("Switching to level");
-    parent->set_current_scene(new Level(app, parent));
+    app->scenes->start_level();
 }
 
 void MainMenu::open_settings() {
     spdlog::info("Switching to settings");
-    parent->set_current_scene(new SettingsScreen(app, parent));
+    app->scenes->open_settings();
 }
 
-MainMenu::MainMenu(App* app, SceneManager* p)
-    : parent(p)
-    , buttons(32.0f)
+MainMenu::MainMenu(App* app)
+    : buttons(32.0f)
     , app(app) {
 
     buttons.set_pos({get_window_width() / 2.0f, get_window_height() / 2.0f});
@@ -219,7 +304,14 @@ MainMenu::MainMenu(App* app, SceneManager* p)
     buttons.center();
 }
 
+void MainMenu::reset() {
+    for (int i = MM_NEWGAME; i <= MM_EXIT; i++) {
+        buttons[i]->reset_state();
+    }
+}
+
 void MainMenu::update(float) {
+    PROFILE_SCOPE(ProfSection::ui);
     // TODO: add keyboard controller, toggle manual update mode on and off,
     // depending on what happend the last - some valid key press or mouse movement
     buttons.update();
@@ -241,5 +333,10 @@ void MainMenu::update(float) {
 }
 
 void MainMenu::draw() {
+    PROFILE_SCOPE(ProfSection::ui);
     buttons.draw();
 }
+
+bool MainMenu::is_idle() const {
+    return true;
+}
@@ -1,27 +1,34 @@
 #pragma once
 
+#include "frame_pacer.hpp"
+#include "idle.hpp"
+#include "performance.hpp"
+
 #include "engine/core.hpp"
+#include "engine/settings.hpp"
 #include "engine/ui.hpp"
 #include "engine/utility.hpp"
 #include "raylib.h"
 
+#include <vector>
+
 class App;
 
-class TitleScreen : public Scene {
+class TitleScreen : public Scene, public IdleReporter {
 private:
-    SceneManager* parent;
     Timer timer;
     Label greeter;
     App* app;
 
 public:
-    TitleScreen(App* app, SceneManager* p);
+    TitleScreen(App* app);
 
     void update(float dt) override;
     void draw() override;
+    bool is_idle() const override;
 };
 
-class MainMenu : public Scene {
+class MainMenu : public Scene, public IdleReporter {
 private:
     enum MM_BUTTONS {
         MM_NEWGAME,
@@ -30,7 +37,6 @@ private:
         MM_CONTINUE
     };
 
-    SceneManager* parent;
     VerticalContainer buttons;
     App* app;
 
@@ -39,8 +45,62 @@ private:
     void open_settings();
 
 public:
-    MainMenu(App* app, SceneManager* p);
+    MainMenu(App* app);
+
+    // Reset buttons' state. Must be called before showing cached menu again.
+    void reset();
+
+    void update(float) override;
+    void draw() override;
+    bool is_idle() const override;
+};
+
+class SettingsScreen : public Scene, public IdleReporter {
+private:
+    // It may be done without this thing, but will do for now
+    toml::table current_settings;
+
+    Label title;
+    Label unsaved_changes_msg;
+    bool settings_changed;
+
+    Button* save_button;
+    Button* exit_button;
+
+    Label show_fps_title;
+    Checkbox* fps_cb;
+
+    Label fullscreen_title;
+    Checkbox* fullscreen_cb;
+
+    Label show_profiler_title;
+    Checkbox* profiler_cb;
+
+    Label pacing_title;
+    Label pacing_value;
+    Button* pacing_button;
+    PacingMode pacing_mode;
+
+    // Column of performance tunables, one row per PerformanceOption
+    Label performance_title;
+    std::vector<Label> performance_titles;
+    std::vector<Label> performance_values;
+    std::vector<Button*> performance_buttons;
+    PerformanceSettings performance;
+
+    App* app;
+
+    void exit_to_menu();
+    void save_settings();
+
+public:
+    SettingsScreen(App* app);
+    ~SettingsScreen();
+
+    // Returns true if some toggles differ from saved settings
+    bool has_unsaved_changes();
 
     void update(float) override;
     void draw() override;
+    bool is_idle() const override;
 };
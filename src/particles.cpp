@@ -0,0 +1,197 @@
+#include "particles.hpp"
+
+#include "jobs.hpp"
+
+#include <rlgl.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Particles in a burst: base amount plus more for bigger balloons
+static constexpr float BURST_BASE = 8.0f;
+static constexpr float BURST_PER_RADIUS = 0.25f;
+// Bursts are full-sized till pool is that much full, then shrink linearly
+static constexpr float BURST_SHRINK_AT = 0.5f;
+
+static constexpr float MIN_SPEED = 60.0f;
+static constexpr float MAX_SPEED = 220.0f;
+static constexpr float MIN_LIFETIME = 0.4f;
+static constexpr float MAX_LIFETIME = 0.9f;
+static constexpr float MIN_SIZE = 2.0f;
+static constexpr float MAX_SIZE = 5.0f;
+// Chance of confetti being white instead of balloon's color
+static constexpr float WHITE_SHARE = 0.3f;
+
+// Confetti falls down, while being slowed by air
+static constexpr float GRAVITY = 300.0f;
+static constexpr float DRAG = 2.0f;
+
+// Particles drawn between batch limit checks. Each takes 6 vertices, thus that
+// fits into raylib's default batch with room to spare.
+static constexpr std::size_t DRAW_CHUNK = 1024;
+// Particles integrated per job. Less than that isn't worth the scheduling.
+static constexpr std::size_t UPDATE_GRAIN = 4096;
+
+static constexpr float TWO_PI = 6.2831853f;
+
+ParticleSystem::ParticleSystem(std::size_t capacity)
+    : capacity(capacity)
+    , limit(capacity)
+    , alive(0)
+    , pos_x(capacity)
+    , pos_y(capacity)
+    , vel_x(capacity)
+    , vel_y(capacity)
+    , life(capacity)
+    , inv_lifetime(capacity)
+    , size(capacity)
+    , color(capacity)
+    , rng_state(0x9E3779B9u)
+    , peak(0)
+    , emitted(0)
+    , dropped(0) {}
+
+float ParticleSystem::random(float min, float max) {
+    // xorshift32. Quality doesn't matter here, speed does.
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    const float unit = static_cast<float>(rng_state >> 8) * (1.0f / 16777216.0f);
+    return min + (max - min) * unit;
+}
+
+void ParticleSystem::set_budget(float share) {
+    share = std::clamp(share, 0.0f, 1.0f);
+    limit = static_cast<std::size_t>(static_cast<float>(capacity) * share);
+}
+
+void ParticleSystem::emit_pop(Vector2 pos, float radius, Color balloon_color) {
+    const auto requested = static_cast<std::size_t>(BURST_BASE + radius * BURST_PER_RADIUS);
+
+    float scale = 0.0f;
+    if (alive < limit) {
+        const float fill = static_cast<float>(alive) / static_cast<float>(limit);
+        scale = fill < BURST_SHRINK_AT ? 1.0f : (1.0f - fill) / (1.0f - BURST_SHRINK_AT);
+    }
+
+    std::size_t amount = static_cast<std::size_t>(static_cast<float>(requested) * scale);
+    amount = std::min(amount, limit > alive ? limit - alive : 0);
+    dropped += requested - amount;
+    emitted += amount;
+
+    for (std::size_t n = 0; n < amount; n++) {
+        const std::size_t i = alive++;
+
+        const float angle = random(0.0f, TWO_PI);
+        const float dir_x = std::cos(angle);
+        const float dir_y = std::sin(angle);
+        const float offset = random(0.0f, radius);
+        const float speed = random(MIN_SPEED, MAX_SPEED);
+        const float lifetime = random(MIN_LIFETIME, MAX_LIFETIME);
+
+        pos_x[i] = pos.x + dir_x * offset;
+        pos_y[i] = pos.y + dir_y * offset;
+        vel_x[i] = dir_x * speed;
+        vel_y[i] = dir_y * speed;
+        life[i] = lifetime;
+        inv_lifetime[i] = 1.0f / lifetime;
+        size[i] = random(MIN_SIZE, MAX_SIZE);
+        color[i] = random(0.0f, 1.0f) < WHITE_SHARE ? WHITE : balloon_color;
+    }
+
+    peak = std::max(peak, alive);
+}
+
+void ParticleSystem::integrate(std::size_t begin, std::size_t end, float dt) {
+    const float drag = std::max(1.0f - DRAG * dt, 0.0f);
+    const float gravity = GRAVITY * dt;
+
+    // Separate loops over separate arrays, so each of these gets vectorized
+    float* __restrict vx = vel_x.data();
+    float* __restrict vy = vel_y.data();
+    float* __restrict px = pos_x.data();
+    float* __restrict py = pos_y.data();
+    float* __restrict lf = life.data();
+
+    for (std::size_t i = begin; i < end; i++) {
+        vx[i] *= drag;
+        vy[i] = vy[i] * drag + gravity;
+    }
+    for (std::size_t i = begin; i < end; i++) {
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+    }
+    for (std::size_t i = begin; i < end; i++) {
+        lf[i] -= dt;
+    }
+}
+
+void ParticleSystem::update(float dt, JobSystem& jobs) {
+    jobs.parallel_for(alive, UPDATE_GRAIN, [this, dt](std::size_t begin, std::size_t end) {
+        integrate(begin, end, dt);
+    });
+
+    // Dead particles are replaced with the last alive ones, so alive ones stay
+    // packed. Order doesn't matter, since these are all drawn the same way.
+    std::size_t i = 0;
+    while (i < alive) {
+        if (life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+
+        alive--;
+        pos_x[i] = pos_x[alive];
+        pos_y[i] = pos_y[alive];
+        vel_x[i] = vel_x[alive];
+        vel_y[i] = vel_y[alive];
+        life[i] = life[alive];
+        inv_lifetime[i] = inv_lifetime[alive];
+        size[i] = size[alive];
+        color[i] = color[alive];
+    }
+}
+
+void ParticleSystem::draw() const {
+    for (std::size_t start = 0; start < alive; start += DRAW_CHUNK) {
+        const std::size_t end = std::min(start + DRAW_CHUNK, alive);
+        rlCheckRenderBatchLimit(static_cast<int>((end - start) * 6));
+
+        rlBegin(RL_TRIANGLES);
+        for (std::size_t i = start; i < end; i++) {
+            const float fade = std::min(life[i] * inv_lifetime[i], 1.0f);
+            rlColor4ub(
+                color[i].r,
+                color[i].g,
+                color[i].b,
+                static_cast<unsigned char>(static_cast<float>(color[i].a) * fade));
+
+            const float half = size[i] * 0.5f;
+            const float left = pos_x[i] - half;
+            const float right = pos_x[i] + half;
+            const float top = pos_y[i] - half;
+            const float bottom = pos_y[i] + half;
+
+            rlVertex2f(left, top);
+            rlVertex2f(left, bottom);
+            rlVertex2f(right, bottom);
+
+            rlVertex2f(left, top);
+            rlVertex2f(right, bottom);
+            rlVertex2f(right, top);
+        }
+        rlEnd();
+    }
+}
+
+std::size_t ParticleSystem::get_capacity() const {
+    return capacity;
+}
+
+std::size_t ParticleSystem::get_limit() const {
+    return limit;
+}
+
+ParticleSystem::Stats ParticleSystem::get_stats() const {
+    return {alive, peak, emitted, dropped};
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Short-living visual particles (e.g confetti of popped balloons). These aren't
+// entities and have no physics bodies - instead, each attribute is stored in its
+// own fixed-size array, and alive particles are kept packed at the start of
+// these. Thus updating them is a few tight loops over contiguous floats, that
+// compiler can vectorize.
+//
+// Pool never grows. Once particle limit is reached, new particles are dropped
+// (and counted), so the worst case cost is that of a full pool. To make it less
+// noticeable, bursts get smaller as pool fills up.
+class ParticleSystem {
+public:
+    struct Stats {
+        std::size_t alive;
+        // The most particles that have been alive at once
+        std::size_t peak;
+        std::size_t emitted;
+        std::size_t dropped;
+    };
+
+    ParticleSystem(std::size_t capacity);
+
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    // Share of capacity that may be used, 0-1. Particles that are already alive
+    // are kept, even if there are more of them than the new limit.
+    void set_budget(float share);
+
+    // Burst of confetti flying away from popped balloon
+    void emit_pop(Vector2 pos, float radius, Color color);
+
+    // Particles are integrated in parallel, if there are enough of them
+    void update(float dt, JobSystem& jobs);
+    // Draws everything as a single batch. Must be called in 2D mode.
+    void draw() const;
+
+    std::size_t get_capacity() const;
+    std::size_t get_limit() const;
+    Stats get_stats() const;
+
+private:
+    std::size_t capacity;
+    std::size_t limit;
+    std::size_t alive;
+
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    std::vector<float> vel_x;
+    std::vector<float> vel_y;
+    // Seconds left, and inverse of the total lifetime (used for fading)
+    std::vector<float> life;
+    std::vector<float> inv_lifetime;
+    std::vector<float> size;
+    std::vector<Color> color;
+
+    std::uint32_t rng_state;
+
+    std::size_t peak;
+    std::size_t emitted;
+    std::size_t dropped;
+
+    // Random float in [min, max)
+    float random(float min, float max);
+    // Move and age particles in [begin, end)
+    void integrate(std::size_t begin, std::size_t end, float dt);
+};
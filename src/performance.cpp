@@ -0,0 +1,208 @@
+#include "performance.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+static constexpr std::size_t OPTIONS = static_cast<std::size_t>(PerformanceOption::count);
+
+static constexpr const char* OPTION_TITLES[OPTIONS] = {
+    "Physics Rate:",
+    "Velocity Iters:",
+    "Position Iters:",
+    "Max Balloons:",
+    "Spawn Interval:",
+    "Log Level:",
+};
+
+static constexpr float PHYSICS_RATES[] = {30.0f, 45.0f, 60.0f, 90.0f, 120.0f};
+static constexpr int VELOCITY_ITERATIONS[] = {2, 3, 4, 6, 8, 10};
+static constexpr int POSITION_ITERATIONS[] = {1, 2, 3, 4};
+static constexpr int MAX_BALLOONS[] = {15, 30, 60, 120, 250};
+static constexpr float SPAWN_INTERVALS[] = {1.0f, 2.0f, 3.5f, 5.0f};
+static constexpr const char* LOG_LEVELS[] = {"trace", "debug", "info", "warn", "error"};
+
+// Level always starts with at least 10 balloons, and spawns up to max_balloons
+static constexpr int MIN_BALLOONS = 11;
+static constexpr int MAX_BALLOONS_LIMIT = 1000;
+
+template <typename T>
+static T clamp_setting(const char* name, T value, T min, T max) {
+    const T clamped = std::clamp(value, min, max);
+    if (clamped != value) {
+        spdlog::warn(
+            "performance.{} = {} is out of range [{}, {}], using {}",
+            name,
+            value,
+            min,
+            max,
+            clamped);
+    }
+    return clamped;
+}
+
+// Preset that follows current value, or the first one if value isn't a preset
+template <typename T, std::size_t N>
+static T next_preset(const T (&presets)[N], const T& value) {
+    for (std::size_t i = 0; i < N; i++) {
+        if (presets[i] == value) {
+            return presets[(i + 1) % N];
+        }
+    }
+    return presets[0];
+}
+
+bool operator==(const PerformanceSettings& lhs, const PerformanceSettings& rhs) {
+    return lhs.physics_rate == rhs.physics_rate &&
+           lhs.velocity_iterations == rhs.velocity_iterations &&
+           lhs.position_iterations == rhs.position_iterations &&
+           lhs.max_balloons == rhs.max_balloons &&
+           lhs.spawn_interval == rhs.spawn_interval &&
+           lhs.wind_min_interval == rhs.wind_min_interval &&
+           lhs.wind_max_interval == rhs.wind_max_interval &&
+           lhs.wind_min_power == rhs.wind_min_power &&
+           lhs.wind_max_power == rhs.wind_max_power && lhs.log_level == rhs.log_level;
+}
+
+bool operator!=(const PerformanceSettings& lhs, const PerformanceSettings& rhs) {
+    return !(lhs == rhs);
+}
+
+PerformanceSettings load_performance_settings(const toml::table& settings) {
+    const PerformanceSettings defaults;
+    const auto table = settings["performance"];
+
+    PerformanceSettings perf;
+    perf.physics_rate = clamp_setting(
+        "physics_rate", table["physics_rate"].value_or(defaults.physics_rate), 15.0f, 240.0f);
+    perf.velocity_iterations = clamp_setting(
+        "velocity_iterations",
+        table["velocity_iterations"].value_or(defaults.velocity_iterations),
+        1,
+        20);
+    perf.position_iterations = clamp_setting(
+        "position_iterations",
+        table["position_iterations"].value_or(defaults.position_iterations),
+        1,
+        20);
+    perf.max_balloons = clamp_setting(
+        "max_balloons",
+        table["max_balloons"].value_or(defaults.max_balloons),
+        MIN_BALLOONS,
+        MAX_BALLOONS_LIMIT);
+    perf.spawn_interval = clamp_setting(
+        "spawn_interval",
+        table["spawn_interval"].value_or(defaults.spawn_interval),
+        0.1f,
+        60.0f);
+
+    perf.wind_min_interval = clamp_setting(
+        "wind_min_interval",
+        table["wind_min_interval"].value_or(defaults.wind_min_interval),
+        0.1f,
+        60.0f);
+    perf.wind_max_interval = clamp_setting(
+        "wind_max_interval",
+        table["wind_max_interval"].value_or(defaults.wind_max_interval),
+        perf.wind_min_interval,
+        60.0f);
+    perf.wind_min_power = clamp_setting(
+        "wind_min_power",
+        table["wind_min_power"].value_or(defaults.wind_min_power),
+        0.0f,
+        5000.0f);
+    perf.wind_max_power = clamp_setting(
+        "wind_max_power",
+        table["wind_max_power"].value_or(defaults.wind_max_power),
+        perf.wind_min_power,
+        5000.0f);
+
+    perf.log_level = table["log_level"].value_or(defaults.log_level);
+    // from_str() returns "off" for anything it doesn't know
+    if (spdlog::level::from_str(perf.log_level) == spdlog::level::off &&
+        perf.log_level != "off") {
+        spdlog::warn(
+            "performance.log_level = \"{}\" is unknown, using \"{}\"",
+            perf.log_level,
+            defaults.log_level);
+        perf.log_level = defaults.log_level;
+    }
+
+    return perf;
+}
+
+toml::table make_performance_table(const PerformanceSettings& perf) {
+    // toml only has 64-bit floats, so these are widened explicitly
+    return toml::table{
+        {"physics_rate", static_cast<double>(perf.physics_rate)},
+        {"velocity_iterations", perf.velocity_iterations},
+        {"position_iterations", perf.position_iterations},
+        {"max_balloons", perf.max_balloons},
+        {"spawn_interval", static_cast<double>(perf.spawn_interval)},
+        {"wind_min_interval", static_cast<double>(perf.wind_min_interval)},
+        {"wind_max_interval", static_cast<double>(perf.wind_max_interval)},
+        {"wind_min_power", static_cast<double>(perf.wind_min_power)},
+        {"wind_max_power", static_cast<double>(perf.wind_max_power)},
+        {"log_level", perf.log_level}};
+}
+
+const char* get_performance_option_title(PerformanceOption option) {
+    return OPTION_TITLES[static_cast<std::size_t>(option)];
+}
+
+std::string get_performance_option_value(
+    const PerformanceSettings& perf, PerformanceOption option) {
+    switch (option) {
+    case PerformanceOption::physics_rate:
+        return fmt::format("{:g} Hz", perf.physics_rate);
+    case PerformanceOption::velocity_iterations:
+        return fmt::format("{}", perf.velocity_iterations);
+    case PerformanceOption::position_iterations:
+        return fmt::format("{}", perf.position_iterations);
+    case PerformanceOption::max_balloons:
+        return fmt::format("{}", perf.max_balloons);
+    case PerformanceOption::spawn_interval:
+        return fmt::format("{:g} s", perf.spawn_interval);
+    case PerformanceOption::log_level:
+        return perf.log_level;
+    default:
+        return "";
+    }
+}
+
+void cycle_performance_option(PerformanceSettings& perf, PerformanceOption option) {
+    switch (option) {
+    case PerformanceOption::physics_rate:
+        perf.physics_rate = next_preset(PHYSICS_RATES, perf.physics_rate);
+        break;
+    case PerformanceOption::velocity_iterations:
+        perf.velocity_iterations = next_preset(VELOCITY_ITERATIONS, perf.velocity_iterations);
+        break;
+    case PerformanceOption::position_iterations:
+        perf.position_iterations = next_preset(POSITION_ITERATIONS, perf.position_iterations);
+        break;
+    case PerformanceOption::max_balloons:
+        perf.max_balloons = next_preset(MAX_BALLOONS, perf.max_balloons);
+        break;
+    case PerformanceOption::spawn_interval:
+        perf.spawn_interval = next_preset(SPAWN_INTERVALS, perf.spawn_interval);
+        break;
+    case PerformanceOption::log_level: {
+        const char* level = LOG_LEVELS[0];
+        for (std::size_t i = 0; i < std::size(LOG_LEVELS); i++) {
+            if (perf.log_level == LOG_LEVELS[i]) {
+                level = LOG_LEVELS[(i + 1) % std::size(LOG_LEVELS)];
+                break;
+            }
+        }
+        perf.log_level = level;
+        break;
+    }
+    default:
+        break;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <engine/settings.hpp>
+
+#include <cstdint>
+#include <string>
+
+// Knobs stored in [performance] table of settings.toml. These let tune the game
+// for particular machine without recompiling it. Level picks changes up on the
+// next frame, even if it's already running.
+struct PerformanceSettings {
+    // Physics steps per second
+    float physics_rate = 60.0f;
+    int velocity_iterations = 6;
+    int position_iterations = 2;
+    // Balls are only spawned while there are less than that many on screen
+    int max_balloons = 30;
+    // Seconds between spawns
+    float spawn_interval = 3.5f;
+    // Seconds between gusts of wind, and their power
+    float wind_min_interval = 3.0f;
+    float wind_max_interval = 5.0f;
+    float wind_min_power = 100.0f;
+    float wind_max_power = 300.0f;
+    // Level of all log subsystems, unless overridden via log_levels
+    std::string log_level = "info";
+};
+
+bool operator==(const PerformanceSettings& lhs, const PerformanceSettings& rhs);
+bool operator!=(const PerformanceSettings& lhs, const PerformanceSettings& rhs);
+
+// Reads [performance] table. Missing values are set to defaults, invalid ones
+// are clamped into sane range (with a warning).
+PerformanceSettings load_performance_settings(const toml::table& settings);
+// Inverse of the above, e.g for saving settings
+toml::table make_performance_table(const PerformanceSettings& perf);
+
+// Tunables that can be changed from settings screen. Wind's ones are only
+// available via settings.toml
+enum class PerformanceOption : std::uint8_t {
+    physics_rate,
+    velocity_iterations,
+    position_iterations,
+    max_balloons,
+    spawn_interval,
+    log_level,
+    count
+};
+
+const char* get_performance_option_title(PerformanceOption option);
+std::string get_performance_option_value(
+    const PerformanceSettings& perf, PerformanceOption option);
+// Switch option to the next of its presets. Wraps around after the last one,
+// and goes to the first one if current value isn't a preset.
+void cycle_performance_option(PerformanceSettings& perf, PerformanceOption option);
@@ -0,0 +1,192 @@
+#include "physics_checker.hpp"
+
+#include "components.hpp"
+
+#include <engine/utility.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <string>
+
+static constexpr std::size_t TOUCHED_RESERVE = 256;
+
+// Failed checks are always logged, so there is a trace even if assertion
+// doesn't end up stopping the game.
+#define PHYS_CHECK(cond, ...)                                                            \
+    do {                                                                                 \
+        if (!(cond)) {                                                                   \
+            spdlog::error(__VA_ARGS__);                                                  \
+            ASSERT(cond);                                                                \
+        }                                                                                \
+    } while (false)
+
+PhysicsChecker::PhysicsChecker(entt::registry& registry, PhysicsShards& shards)
+    : registry(registry)
+    , shards(shards)
+    , level(PhysicsCheckLevel::off)
+    , sweep_interval(300)
+    , frames_since_sweep(0)
+    , tracked(0) {
+    touched.reserve(TOUCHED_RESERVE);
+#if GAME_PHYSICS_CHECKS > 0
+    registry.on_construct<PhysicsBodyComponent>().connect<&PhysicsChecker::on_construct>(
+        this);
+    registry.on_destroy<PhysicsBodyComponent>().connect<&PhysicsChecker::on_destroy>(this);
+#endif
+}
+
+PhysicsChecker::~PhysicsChecker() {
+#if GAME_PHYSICS_CHECKS > 0
+    registry.on_construct<PhysicsBodyComponent>()
+        .disconnect<&PhysicsChecker::on_construct>(this);
+    registry.on_destroy<PhysicsBodyComponent>().disconnect<&PhysicsChecker::on_destroy>(
+        this);
+#endif
+}
+
+void PhysicsChecker::set_level(PhysicsCheckLevel lvl) {
+    const auto max_level = static_cast<PhysicsCheckLevel>(GAME_PHYSICS_CHECKS);
+    if (lvl > max_level) {
+        spdlog::debug(
+            "Physics check level {} is not compiled in, using {}",
+            static_cast<int>(lvl),
+            GAME_PHYSICS_CHECKS);
+        lvl = max_level;
+    }
+    level = lvl;
+}
+
+PhysicsCheckLevel PhysicsChecker::get_level() const {
+    return level;
+}
+
+void PhysicsChecker::set_sweep_interval(int frames) {
+    sweep_interval = std::max(frames, 1);
+}
+
+void PhysicsChecker::on_construct(entt::registry&, entt::entity e) {
+    tracked++;
+    if (level != PhysicsCheckLevel::off) {
+        touched.push_back(e);
+    }
+}
+
+void PhysicsChecker::on_destroy(entt::registry& reg, entt::entity e) {
+    tracked--;
+    if (level != PhysicsCheckLevel::off) {
+        PHYS_CHECK(
+            reg.get<PhysicsBodyComponent>(e).body != nullptr,
+            "Entity {} is being destroyed without physics body",
+            static_cast<uint32_t>(e));
+    }
+}
+
+void PhysicsChecker::check_entity(entt::entity e) {
+    // Entity may have been created and destroyed between two checks
+    if (!registry.valid(e)) {
+        return;
+    }
+    auto comp = registry.try_get<PhysicsBodyComponent>(e);
+    if (comp == nullptr) {
+        return;
+    }
+
+    const auto id = static_cast<uint32_t>(e);
+    PHYS_CHECK(comp->body != nullptr, "Entity {} has no physics body", id);
+    PHYS_CHECK(
+        shards.owns(comp->body->GetWorld()),
+        "Body of entity {} belongs to a foreign world",
+        id);
+    PHYS_CHECK(
+        get_entity(comp->body) == e,
+        "Body of entity {} points to entity {}",
+        id,
+        static_cast<uint32_t>(get_entity(comp->body)));
+
+    for (auto f = comp->body->GetFixtureList(); f != nullptr; f = f->GetNext()) {
+        PHYS_CHECK(
+            get_entity(f) == e,
+            "Fixture of entity {} points to entity {}",
+            id,
+            static_cast<uint32_t>(get_entity(f)));
+    }
+}
+
+void PhysicsChecker::check() {
+#if GAME_PHYSICS_CHECKS > 0
+    if (level == PhysicsCheckLevel::off) {
+        touched.clear();
+        return;
+    }
+
+    for (auto e : touched) {
+        check_entity(e);
+    }
+    touched.clear();
+
+    // Bodies are only created and destroyed together with their components
+    PHYS_CHECK(
+        static_cast<std::size_t>(shards.get_body_count()) == tracked,
+        "Physics has {} bodies, but {} entities have physics component",
+        shards.get_body_count(),
+        tracked);
+#endif
+}
+
+void PhysicsChecker::full_sweep() {
+#if GAME_PHYSICS_CHECKS > 1
+    std::size_t bodies = 0;
+    shards.for_each_world([this, &bodies](b2World& world) {
+        for (auto body = world.GetBodyList(); body != nullptr; body = body->GetNext()) {
+            if (PhysicsShards::is_ghost(body)) {
+                continue;
+            }
+            bodies++;
+            const auto e = get_entity(body);
+            PHYS_CHECK(
+                registry.valid(e),
+                "Body points to entity {}, which no longer exists",
+                static_cast<uint32_t>(e));
+            auto comp = registry.try_get<PhysicsBodyComponent>(e);
+            PHYS_CHECK(
+                comp != nullptr && comp->body == body,
+                "Body points to entity {}, which doesn't own it",
+                static_cast<uint32_t>(e));
+        }
+    });
+
+    auto view = registry.view<PhysicsBodyComponent>();
+    for (auto e : view) {
+        check_entity(e);
+    }
+
+    PHYS_CHECK(
+        bodies == tracked,
+        "Physics has {} bodies, but {} entities have physics component",
+        bodies,
+        tracked);
+#endif
+}
+
+void PhysicsChecker::update() {
+    if (level != PhysicsCheckLevel::full) {
+        return;
+    }
+
+    frames_since_sweep++;
+    if (frames_since_sweep >= sweep_interval) {
+        frames_since_sweep = 0;
+        full_sweep();
+    }
+}
+
+PhysicsCheckLevel parse_physics_check_level(const std::string& txt) {
+    if (txt == "off") {
+        return PhysicsCheckLevel::off;
+    }
+    if (txt == "full") {
+        return PhysicsCheckLevel::full;
+    }
+    return PhysicsCheckLevel::touched;
+}
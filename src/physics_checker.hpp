@@ -0,0 +1,70 @@
+#pragma once
+
+#include "box2d/box2d.h"
+#include "entt/entity/registry.hpp"
+#include "physics_shards.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Highest check level compiled in. 0 - no checks at all, 1 - only entities
+// touched since last check, 2 - also full sweeps. Set by CMake.
+#if !defined(GAME_PHYSICS_CHECKS)
+#define GAME_PHYSICS_CHECKS 0
+#endif
+
+enum class PhysicsCheckLevel {
+    off,
+    // Verify entities that have been created or destroyed since last check
+    touched,
+    // Same as above, but also verify everything every few frames
+    full
+};
+
+// Keeps track of entities with PhysicsBodyComponent via registry's hooks and
+// verifies that these are consistent with bodies of physics shards. Unlike checking the
+// whole world after each change, cost depends only on amount of changes.
+class PhysicsChecker {
+private:
+    entt::registry& registry;
+    PhysicsShards& shards;
+
+    PhysicsCheckLevel level;
+    int sweep_interval;
+    int frames_since_sweep;
+
+    // Entities with physics body created since last check
+    std::vector<entt::entity> touched;
+    // Amount of entities with physics body. Maintained by hooks, so it can be
+    // compared with shards' body count without iterating either of these.
+    std::size_t tracked;
+
+    void on_construct(entt::registry& reg, entt::entity e);
+    void on_destroy(entt::registry& reg, entt::entity e);
+
+    void check_entity(entt::entity e);
+
+public:
+    PhysicsChecker(entt::registry& registry, PhysicsShards& shards);
+    ~PhysicsChecker();
+
+    PhysicsChecker(const PhysicsChecker&) = delete;
+    PhysicsChecker& operator=(const PhysicsChecker&) = delete;
+
+    // Level is clamped to the one compiled in
+    void set_level(PhysicsCheckLevel level);
+    PhysicsCheckLevel get_level() const;
+    // Frames between full sweeps, if level is PhysicsCheckLevel::full
+    void set_sweep_interval(int frames);
+
+    // Verify entities touched since last check
+    void check();
+    // Verify every body of every shard and every entity with physics component
+    void full_sweep();
+    // Must be called once per frame. Runs full sweep when it's due.
+    void update();
+};
+
+// Parse level from settings' string ("off", "touched" or "full")
+PhysicsCheckLevel parse_physics_check_level(const std::string& txt);
@@ -0,0 +1,260 @@
+#include "physics_debug.hpp"
+
+#include <box2d/b2_body.h>
+#include <box2d/b2_contact.h>
+
+#include <fmt/format.h>
+
+#include <rlgl.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+static constexpr int CIRCLE_SEGMENTS = 16;
+// Vertices submitted between batch limit checks. Divisible by both 2 and 3, so
+// lines and triangles never get split between chunks.
+static constexpr std::size_t DRAW_CHUNK = 6144;
+// Enough for a few thousands of circles, so lists don't grow every frame
+static constexpr std::size_t LINES_RESERVE = 64 * 1024;
+static constexpr std::size_t TRIANGLES_RESERVE = 64 * 1024;
+
+static constexpr float FILL_ALPHA = 0.25f;
+static constexpr float TRANSFORM_AXIS = 10.0f;
+static constexpr float CONTACT_POINT_SIZE = 4.0f;
+static constexpr float CONTACT_NORMAL = 8.0f;
+// Shards' edges are infinite, but that's long enough
+static constexpr float SHARD_EDGE_LENGTH = 100000.0f;
+static constexpr int FONT_SIZE = 10;
+static constexpr int LINE_HEIGHT = 12;
+
+// Unit circle, shared by all circles
+static const std::array<b2Vec2, CIRCLE_SEGMENTS>& get_circle() {
+    static const auto points = [] {
+        std::array<b2Vec2, CIRCLE_SEGMENTS> result;
+        for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+            const float angle = 2.0f * PI * static_cast<float>(i) / CIRCLE_SEGMENTS;
+            result[static_cast<std::size_t>(i)] = {std::cos(angle), std::sin(angle)};
+        }
+        return result;
+    }();
+    return points;
+}
+
+static Color to_color(const b2Color& color, float alpha = 1.0f) {
+    return {
+        static_cast<unsigned char>(color.r * 255.0f),
+        static_cast<unsigned char>(color.g * 255.0f),
+        static_cast<unsigned char>(color.b * 255.0f),
+        static_cast<unsigned char>(color.a * alpha * 255.0f)};
+}
+
+PhysicsDebugDraw::PhysicsDebugDraw()
+    : stats() {
+    SetFlags(e_shapeBit | e_aabbBit);
+    lines.reserve(LINES_RESERVE);
+    triangles.reserve(TRIANGLES_RESERVE);
+}
+
+void PhysicsDebugDraw::add_line(b2Vec2 a, b2Vec2 b, Color color) {
+    lines.push_back({a.x, a.y, color});
+    lines.push_back({b.x, b.y, color});
+}
+
+void PhysicsDebugDraw::add_triangle(b2Vec2 a, b2Vec2 b, b2Vec2 c, Color color) {
+    triangles.push_back({a.x, a.y, color});
+    triangles.push_back({b.x, b.y, color});
+    triangles.push_back({c.x, c.y, color});
+}
+
+void PhysicsDebugDraw::DrawPolygon(
+    const b2Vec2* vertices, int32 vertexCount, const b2Color& color) {
+    const Color c = to_color(color);
+    for (int32 i = 0; i < vertexCount; i++) {
+        add_line(vertices[i], vertices[(i + 1) % vertexCount], c);
+    }
+}
+
+void PhysicsDebugDraw::DrawSolidPolygon(
+    const b2Vec2* vertices, int32 vertexCount, const b2Color& color) {
+    const Color fill = to_color(color, FILL_ALPHA);
+    for (int32 i = 1; i + 1 < vertexCount; i++) {
+        add_triangle(vertices[0], vertices[i + 1], vertices[i], fill);
+    }
+    DrawPolygon(vertices, vertexCount, color);
+}
+
+void PhysicsDebugDraw::DrawCircle(
+    const b2Vec2& center, float radius, const b2Color& color) {
+    const Color c = to_color(color);
+    const auto& circle = get_circle();
+    b2Vec2 prev = center + radius * circle.back();
+    for (const auto& point : circle) {
+        const b2Vec2 next = center + radius * point;
+        add_line(prev, next, c);
+        prev = next;
+    }
+}
+
+void PhysicsDebugDraw::DrawSolidCircle(
+    const b2Vec2& center, float radius, const b2Vec2& axis, const b2Color& color) {
+    const Color fill = to_color(color, FILL_ALPHA);
+    const auto& circle = get_circle();
+    b2Vec2 prev = center + radius * circle.back();
+    for (const auto& point : circle) {
+        const b2Vec2 next = center + radius * point;
+        add_triangle(center, next, prev, fill);
+        prev = next;
+    }
+
+    DrawCircle(center, radius, color);
+    // Shows rotation
+    add_line(center, center + radius * axis, to_color(color));
+}
+
+void PhysicsDebugDraw::DrawSegment(
+    const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) {
+    add_line(p1, p2, to_color(color));
+}
+
+void PhysicsDebugDraw::DrawTransform(const b2Transform& xf) {
+    const b2Vec2 x_axis = {
+        xf.p.x + TRANSFORM_AXIS * xf.q.c, xf.p.y + TRANSFORM_AXIS * xf.q.s};
+    const b2Vec2 y_axis = {
+        xf.p.x - TRANSFORM_AXIS * xf.q.s, xf.p.y + TRANSFORM_AXIS * xf.q.c};
+    add_line(xf.p, x_axis, RED);
+    add_line(xf.p, y_axis, GREEN);
+}
+
+void PhysicsDebugDraw::DrawPoint(const b2Vec2& p, float size, const b2Color& color) {
+    const Color c = to_color(color);
+    const float half = size * 0.5f;
+    const b2Vec2 top_left = {p.x - half, p.y - half};
+    const b2Vec2 bottom_right = {p.x + half, p.y + half};
+    add_triangle(top_left, {p.x - half, p.y + half}, bottom_right, c);
+    add_triangle(top_left, bottom_right, {p.x + half, p.y - half}, c);
+}
+
+void PhysicsDebugDraw::collect_stats(b2World& world) {
+    stats.proxies += world.GetProxyCount();
+    stats.contacts += world.GetContactCount();
+    stats.bodies += world.GetBodyCount();
+    stats.tree_height = std::max(stats.tree_height, world.GetTreeHeight());
+    stats.tree_balance = std::max(stats.tree_balance, world.GetTreeBalance());
+    stats.tree_quality = std::max(stats.tree_quality, world.GetTreeQuality());
+
+    const b2Body* body = world.GetBodyList();
+    while (body != nullptr) {
+        if (body->IsAwake()) {
+            stats.awake++;
+        }
+        body = body->GetNext();
+    }
+}
+
+void PhysicsDebugDraw::add_contacts(b2World& world) {
+    const b2Color point_color(1.0f, 0.9f, 0.2f);
+    const Color normal_color = to_color(point_color);
+
+    for (b2Contact* contact = world.GetContactList(); contact != nullptr;
+         contact = contact->GetNext()) {
+        if (!contact->IsTouching()) {
+            continue;
+        }
+        stats.touching++;
+
+        const int32 points = contact->GetManifold()->pointCount;
+        b2WorldManifold manifold;
+        contact->GetWorldManifold(&manifold);
+        for (int32 i = 0; i < points; i++) {
+            const b2Vec2& p = manifold.points[i];
+            DrawPoint(p, CONTACT_POINT_SIZE, point_color);
+            add_line(p, p + CONTACT_NORMAL * manifold.normal, normal_color);
+        }
+    }
+}
+
+void PhysicsDebugDraw::flush() {
+    for (std::size_t start = 0; start < triangles.size(); start += DRAW_CHUNK) {
+        const std::size_t end = std::min(start + DRAW_CHUNK, triangles.size());
+        rlCheckRenderBatchLimit(static_cast<int>(end - start));
+        rlBegin(RL_TRIANGLES);
+        for (std::size_t i = start; i < end; i++) {
+            const auto& v = triangles[i];
+            rlColor4ub(v.color.r, v.color.g, v.color.b, v.color.a);
+            rlVertex2f(v.x, v.y);
+        }
+        rlEnd();
+    }
+
+    for (std::size_t start = 0; start < lines.size(); start += DRAW_CHUNK) {
+        const std::size_t end = std::min(start + DRAW_CHUNK, lines.size());
+        rlCheckRenderBatchLimit(static_cast<int>(end - start));
+        rlBegin(RL_LINES);
+        for (std::size_t i = start; i < end; i++) {
+            const auto& v = lines[i];
+            rlColor4ub(v.color.r, v.color.g, v.color.b, v.color.a);
+            rlVertex2f(v.x, v.y);
+        }
+        rlEnd();
+    }
+
+    lines.clear();
+    triangles.clear();
+}
+
+void PhysicsDebugDraw::draw_world(PhysicsShards& shards, Rectangle view) {
+    stats = Stats();
+
+    // Box2d draws everything in the world, so culling happens per shard
+    shards.for_each_world_in(view.x, view.x + view.width, [this](b2World& world) {
+        stats.shards++;
+        world.SetDebugDraw(this);
+        collect_stats(world);
+        world.DebugDraw();
+        add_contacts(world);
+    });
+
+    const b2Color edge_color(0.3f, 0.9f, 0.9f);
+    for (std::size_t i = 0; i + 1 < shards.get_amount(); i++) {
+        const float x = shards.get_strip_end(i);
+        DrawSegment({x, -SHARD_EDGE_LENGTH}, {x, SHARD_EDGE_LENGTH}, edge_color);
+    }
+
+    flush();
+}
+
+void PhysicsDebugDraw::draw_stats(Vector2 pos) const {
+    const int x = static_cast<int>(pos.x);
+    const int y = static_cast<int>(pos.y);
+
+    DrawText(
+        fmt::format(
+            "proxies {}  contacts {} ({} touching)  bodies {} ({} awake)",
+            stats.proxies,
+            stats.contacts,
+            stats.touching,
+            stats.bodies,
+            stats.awake)
+            .c_str(),
+        x,
+        y,
+        FONT_SIZE,
+        YELLOW);
+    DrawText(
+        fmt::format(
+            "shards drawn {}  tree height {}  balance {}  quality {:.2f}",
+            stats.shards,
+            stats.tree_height,
+            stats.tree_balance,
+            stats.tree_quality)
+            .c_str(),
+        x,
+        y + LINE_HEIGHT,
+        FONT_SIZE,
+        YELLOW);
+}
+
+const PhysicsDebugDraw::Stats& PhysicsDebugDraw::get_stats() const {
+    return stats;
+}
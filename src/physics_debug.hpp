@@ -0,0 +1,81 @@
+#pragma once
+
+#include "physics_shards.hpp"
+
+#include <box2d/b2_draw.h>
+#include <box2d/b2_world.h>
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Box2d's debug draw, for tuning crowds. Shows fixtures (colored by box2d
+// depending on body's state: gray bodies are sleeping, pink ones are awake),
+// fat AABBs of broadphase proxies (i.e leaves of the dynamic tree) and contact
+// points with their normals. Edges between physics shards are shown too.
+//
+// Primitives aren't drawn right away - these are collected into line and
+// triangle lists and then submitted in a few large batches, so drawing stays
+// usable with thousands of bodies.
+class PhysicsDebugDraw : public b2Draw {
+public:
+    struct Stats {
+        int proxies;
+        int contacts;
+        int touching;
+        int bodies;
+        int awake;
+        // Drawn ones only
+        int shards;
+        // The worst of all shards
+        int tree_height;
+        int tree_balance;
+        float tree_quality;
+    };
+
+    PhysicsDebugDraw();
+
+    // Draws worlds of shards that may have anything within view (in world
+    // units). Must be called in 2D mode.
+    void draw_world(PhysicsShards& shards, Rectangle view);
+    // Counts of the last drawn shards, in screen space
+    void draw_stats(Vector2 pos) const;
+    const Stats& get_stats() const;
+
+    void DrawPolygon(
+        const b2Vec2* vertices, int32 vertexCount, const b2Color& color) override;
+    void DrawSolidPolygon(
+        const b2Vec2* vertices, int32 vertexCount, const b2Color& color) override;
+    void DrawCircle(const b2Vec2& center, float radius, const b2Color& color) override;
+    void DrawSolidCircle(
+        const b2Vec2& center,
+        float radius,
+        const b2Vec2& axis,
+        const b2Color& color) override;
+    void DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) override;
+    void DrawTransform(const b2Transform& xf) override;
+    void DrawPoint(const b2Vec2& p, float size, const b2Color& color) override;
+
+private:
+    struct Vertex {
+        float x;
+        float y;
+        Color color;
+    };
+
+    // Pairs of vertices
+    std::vector<Vertex> lines;
+    // Triples of vertices
+    std::vector<Vertex> triangles;
+    Stats stats;
+
+    void add_line(b2Vec2 a, b2Vec2 b, Color color);
+    void add_triangle(b2Vec2 a, b2Vec2 b, b2Vec2 c, Color color);
+    // Add world's counts to stats
+    void collect_stats(b2World& world);
+    void add_contacts(b2World& world);
+    // Submit everything collected and clear lists for the next frame
+    void flush();
+};
@@ -0,0 +1,323 @@
+#include "physics_shards.hpp"
+
+#include "components.hpp"
+#include "jobs.hpp"
+#include "log.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+
+// How far past strip's edge body's center must get before it migrates. Keeps
+// bodies that hover around the edge from jumping back and forth every step.
+static constexpr float MIGRATION_MARGIN = 16.0f;
+// Enough for a typical frame without any reallocations
+static constexpr std::size_t LEAVING_RESERVE = 64;
+static constexpr std::size_t GHOSTS_RESERVE = 256;
+
+// Fixtures of the same shape and material, with given user data
+static void copy_fixtures(b2Body* from, b2Body* to, uintptr_t user_data) {
+    for (b2Fixture* f = from->GetFixtureList(); f != nullptr; f = f->GetNext()) {
+        b2FixtureDef fixture_def;
+        fixture_def.shape = f->GetShape();
+        fixture_def.userData.pointer = user_data;
+        fixture_def.friction = f->GetFriction();
+        fixture_def.restitution = f->GetRestitution();
+        fixture_def.restitutionThreshold = f->GetRestitutionThreshold();
+        fixture_def.density = f->GetDensity();
+        fixture_def.isSensor = f->IsSensor();
+        fixture_def.filter = f->GetFilterData();
+        to->CreateFixture(&fixture_def);
+    }
+}
+
+// Box2d fills some of its static state lazily: contact factory table on the
+// first contact ever created, timer frequency (on Windows) on the first timer.
+// Both are plain writes, thus must happen before worlds are stepped on several
+// threads. A throwaway world with two overlapping circles forces both.
+static void init_box2d_statics() {
+    // Constructed on the main thread, as is everything that owns shards
+    static bool initialized = false;
+    if (initialized) {
+        return;
+    }
+    initialized = true;
+
+    b2World world({0.0f, 0.0f});
+    b2CircleShape circle;
+    circle.m_radius = 1.0f;
+    for (int i = 0; i < 2; i++) {
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        world.CreateBody(&def)->CreateFixture(&circle, 1.0f);
+    }
+    world.Step(1.0f / 60.0f, 1, 1);
+}
+
+PhysicsShards::PhysicsShards(
+    entt::registry& registry, b2Vec2 gravity, float room_width, std::size_t amount)
+    : registry(registry)
+    , strip_width(room_width / static_cast<float>(std::max<std::size_t>(amount, 1)))
+    , reach(MIGRATION_MARGIN)
+    , migrations(0)
+    , sync_frame(0) {
+    init_box2d_statics();
+
+    amount = std::max<std::size_t>(amount, 1);
+    shards.reserve(amount);
+    for (std::size_t i = 0; i < amount; i++) {
+        Shard shard;
+        shard.world = std::make_unique<b2World>(gravity);
+        shard.begin = strip_width * static_cast<float>(i);
+        shard.end = strip_width * static_cast<float>(i + 1);
+        shard.leaving.reserve(LEAVING_RESERVE);
+        if (amount > 1) {
+            shard.ghosts.reserve(GHOSTS_RESERVE);
+        }
+        shards.push_back(std::move(shard));
+    }
+
+    if (amount > 1) {
+        spdlog::info(
+            "Physics is split into {} strips, {} units wide each", amount, strip_width);
+    }
+}
+
+void PhysicsShards::clear() {
+    shards.clear();
+}
+
+std::size_t PhysicsShards::get_amount() const {
+    return shards.size();
+}
+
+b2World& PhysicsShards::get_world(std::size_t shard) {
+    return *shards[shard].world;
+}
+
+const b2World& PhysicsShards::get_world(std::size_t shard) const {
+    return *shards[shard].world;
+}
+
+std::size_t PhysicsShards::get_shard_at(float x) const {
+    if (shards.size() == 1 || x < strip_width) {
+        return 0;
+    }
+    const auto shard = static_cast<std::size_t>(x / strip_width);
+    return std::min(shard, shards.size() - 1);
+}
+
+b2World& PhysicsShards::get_world_at(float x) {
+    return *shards[get_shard_at(x)].world;
+}
+
+float PhysicsShards::get_strip_begin(std::size_t shard) const {
+    return shards[shard].begin;
+}
+
+float PhysicsShards::get_strip_end(std::size_t shard) const {
+    return shards[shard].end;
+}
+
+b2Vec2 PhysicsShards::get_gravity() const {
+    return shards.front().world->GetGravity();
+}
+
+bool PhysicsShards::owns(const b2World* world) const {
+    return std::any_of(shards.begin(), shards.end(), [world](const Shard& shard) {
+        return shard.world.get() == world;
+    });
+}
+
+bool PhysicsShards::is_ghost(b2Body* body) {
+    return body->GetUserData().pointer == to_user_data(entt::null);
+}
+
+int PhysicsShards::get_body_count() const {
+    int count = 0;
+    for (const auto& shard : shards) {
+        count += shard.world->GetBodyCount() - static_cast<int>(shard.ghosts.size());
+    }
+    return count;
+}
+
+std::size_t PhysicsShards::get_ghost_count() const {
+    std::size_t count = 0;
+    for (const auto& shard : shards) {
+        count += shard.ghosts.size();
+    }
+    return count;
+}
+
+std::size_t PhysicsShards::get_migrations() const {
+    return migrations;
+}
+
+void PhysicsShards::set_max_body_extent(float extent) {
+    reach = extent + MIGRATION_MARGIN;
+}
+
+void PhysicsShards::find_leaving(Shard& shard) {
+    shard.leaving.clear();
+    if (shards.size() == 1) {
+        return;
+    }
+
+    // Outermost strips extend to infinity
+    const float begin = &shard == &shards.front() ? -INFINITY : shard.begin;
+    const float end = &shard == &shards.back() ? INFINITY : shard.end;
+
+    b2Body* body = shard.world->GetBodyList();
+    while (body != nullptr) {
+        const float x = body->GetPosition().x;
+        if (body->GetType() == b2_dynamicBody
+            && (x < begin - MIGRATION_MARGIN || x > end + MIGRATION_MARGIN)) {
+            shard.leaving.push_back(body);
+        }
+        body = body->GetNext();
+    }
+}
+
+void PhysicsShards::step(
+    float dt,
+    int velocity_iterations,
+    int position_iterations,
+    [[maybe_unused]] JobSystem& jobs) {
+    sync_ghosts();
+
+#ifdef GAME_PARALLEL_PHYSICS
+    // Besides the statics initialized above, worlds share box2d's global
+    // statistics counters of distance and TOI routines. These must be made
+    // thread local in box2d for this to be race free (see CMakeLists.txt).
+    jobs.parallel_for(shards.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            shards[i].world->Step(dt, velocity_iterations, position_iterations);
+            find_leaving(shards[i]);
+        }
+    });
+#else
+    for (auto& shard : shards) {
+        shard.world->Step(dt, velocity_iterations, position_iterations);
+        find_leaving(shard);
+    }
+#endif
+
+    // Touches two worlds and registry at once, thus can't be done in parallel
+    for (auto& shard : shards) {
+        for (b2Body* body : shard.leaving) {
+            migrate(body, shards[get_shard_at(body->GetPosition().x)]);
+        }
+        shard.leaving.clear();
+    }
+}
+
+void PhysicsShards::destroy_body(b2Body* body) {
+    if (shards.size() > 1) {
+        const entt::entity entity = get_entity(body);
+        for (auto& shard : shards) {
+            remove_ghost(shard, entity);
+        }
+    }
+    body->GetWorld()->DestroyBody(body);
+}
+
+void PhysicsShards::sync_ghosts() {
+    if (shards.size() == 1) {
+        return;
+    }
+
+    sync_frame++;
+    for (std::size_t i = 0; i < shards.size(); i++) {
+        auto& shard = shards[i];
+        for (b2Body* body = shard.world->GetBodyList(); body != nullptr;
+             body = body->GetNext()) {
+            // Dormant balloons touch nothing, thus need no ghosts
+            if (body->GetType() != b2_dynamicBody || !body->IsEnabled()) {
+                continue;
+            }
+            const float x = body->GetPosition().x;
+            if (i > 0 && x < shard.begin + reach) {
+                mirror(body, shards[i - 1]);
+            }
+            if (i + 1 < shards.size() && x > shard.end - reach) {
+                mirror(body, shards[i + 1]);
+            }
+        }
+    }
+
+    // Ghosts of bodies that have left the edge, got disabled or destroyed
+    for (auto& shard : shards) {
+        for (auto it = shard.ghosts.begin(); it != shard.ghosts.end();) {
+            if (it->second.seen != sync_frame) {
+                shard.world->DestroyBody(it->second.body);
+                it = shard.ghosts.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+}
+
+void PhysicsShards::mirror(b2Body* source, Shard& target) {
+    auto& ghost = target.ghosts[get_entity(source)];
+    if (ghost.body == nullptr) {
+        b2BodyDef def;
+        def.type = b2_kinematicBody;
+        def.position = source->GetPosition();
+        def.angle = source->GetAngle();
+        def.userData.pointer = to_user_data(entt::null);
+        ghost.body = target.world->CreateBody(&def);
+        copy_fixtures(source, ghost.body, def.userData.pointer);
+    }
+    else {
+        ghost.body->SetTransform(source->GetPosition(), source->GetAngle());
+    }
+    // Kinematic bodies move by their velocity during the step, thus the ghost
+    // keeps up with its source till the next sync
+    ghost.body->SetLinearVelocity(source->GetLinearVelocity());
+    ghost.body->SetAngularVelocity(source->GetAngularVelocity());
+    ghost.seen = sync_frame;
+}
+
+void PhysicsShards::remove_ghost(Shard& shard, entt::entity entity) {
+    const auto it = shard.ghosts.find(entity);
+    if (it != shard.ghosts.end()) {
+        shard.world->DestroyBody(it->second.body);
+        shard.ghosts.erase(it);
+    }
+}
+
+void PhysicsShards::migrate(b2Body* body, Shard& target) {
+    b2BodyDef def;
+    def.type = body->GetType();
+    def.position = body->GetPosition();
+    def.angle = body->GetAngle();
+    def.linearVelocity = body->GetLinearVelocity();
+    def.angularVelocity = body->GetAngularVelocity();
+    def.linearDamping = body->GetLinearDamping();
+    def.angularDamping = body->GetAngularDamping();
+    def.allowSleep = body->IsSleepingAllowed();
+    def.awake = body->IsAwake();
+    def.fixedRotation = body->IsFixedRotation();
+    def.bullet = body->IsBullet();
+    def.enabled = body->IsEnabled();
+    def.userData = body->GetUserData();
+    def.gravityScale = body->GetGravityScale();
+
+    // Body can't overlap its own ghost
+    const entt::entity entity = get_entity(body);
+    remove_ghost(target, entity);
+
+    b2Body* moved = target.world->CreateBody(&def);
+    copy_fixtures(body, moved, body->GetUserData().pointer);
+
+    LOG_TRACE(
+        physics,
+        "Entity {} moves into another physics shard",
+        static_cast<uint32_t>(entity));
+    registry.get<PhysicsBodyComponent>(entity).body = moved;
+    body->GetWorld()->DestroyBody(body);
+    migrations++;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <box2d/box2d.h>
+#include <entt/entt.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+
+// Room's physics, split into vertical strips of equal width, each with its own
+// b2World. Smaller worlds mean smaller broadphase and islands, and with
+// GAME_PARALLEL_PHYSICS these are stepped in parallel. Each body
+// belongs to the strip its center is in, and moves into the neighbouring world
+// once it gets far enough past the strip's edge.
+//
+// Bodies of different worlds don't collide by themselves. Thus each body within
+// reach of strip's edge gets a ghost in the neighbouring world: a kinematic copy
+// synced before every step, which pushes away that world's bodies. Ghosts of
+// both sides push each other's bodies, so balloons across the edge collide
+// (slightly softer than within a single world). With a single shard (the
+// default) there are no ghosts.
+class PhysicsShards {
+public:
+    PhysicsShards(
+        entt::registry& registry, b2Vec2 gravity, float room_width, std::size_t amount);
+
+    PhysicsShards(const PhysicsShards&) = delete;
+    PhysicsShards& operator=(const PhysicsShards&) = delete;
+
+    std::size_t get_amount() const;
+    b2World& get_world(std::size_t shard);
+    const b2World& get_world(std::size_t shard) const;
+    // Shard whose strip contains x. Anything outside of the room belongs to the
+    // outermost strips.
+    std::size_t get_shard_at(float x) const;
+    b2World& get_world_at(float x);
+    float get_strip_begin(std::size_t shard) const;
+    float get_strip_end(std::size_t shard) const;
+    b2Vec2 get_gravity() const;
+
+    // Whether world is one of shards
+    bool owns(const b2World* world) const;
+    // Ghosts aren't counted
+    int get_body_count() const;
+    std::size_t get_ghost_count() const;
+    // Ghosts belong to no entity and must be skipped by anything that looks for
+    // entities' bodies
+    static bool is_ghost(b2Body* body);
+    // Bodies moved between worlds since creation
+    std::size_t get_migrations() const;
+
+    // Destroy all worlds, together with their bodies. Nothing but destruction
+    // may follow.
+    void clear();
+
+    // Destroy body of an entity, along with its ghosts
+    void destroy_body(b2Body* body);
+
+    // Bodies must not extend more than that from their center, else queries
+    // may miss them near strip edges
+    void set_max_body_extent(float extent);
+
+    // Calls fn(world) for each world that may have fixtures within [min_x, max_x]
+    template <typename F>
+    void for_each_world_in(float min_x, float max_x, F&& fn) const {
+        const std::size_t first = get_shard_at(min_x - reach);
+        const std::size_t last = get_shard_at(max_x + reach);
+        for (std::size_t i = first; i <= last; i++) {
+            fn(static_cast<const b2World&>(*shards[i].world));
+        }
+    }
+
+    template <typename F>
+    void for_each_world_in(float min_x, float max_x, F&& fn) {
+        const std::size_t first = get_shard_at(min_x - reach);
+        const std::size_t last = get_shard_at(max_x + reach);
+        for (std::size_t i = first; i <= last; i++) {
+            fn(*shards[i].world);
+        }
+    }
+
+    template <typename F>
+    void for_each_world(F&& fn) {
+        for (auto& shard : shards) {
+            fn(*shard.world);
+        }
+    }
+
+    // Step every world (in parallel, if compiled in), then move bodies that
+    // have left their strips into worlds they are in now
+    void step(
+        float dt, int velocity_iterations, int position_iterations, JobSystem& jobs);
+
+private:
+    struct Ghost {
+        b2Body* body = nullptr;
+        // Last sync it has been updated by
+        std::uint32_t seen = 0;
+    };
+
+    struct Shard {
+        std::unique_ptr<b2World> world;
+        float begin;
+        float end;
+        // Bodies past strip's edges, found right after stepping
+        std::vector<b2Body*> leaving;
+        // Kinematic copies of neighbours' bodies near this strip's edges
+        std::unordered_map<entt::entity, Ghost> ghosts;
+    };
+
+    entt::registry& registry;
+    std::vector<Shard> shards;
+    float strip_width;
+    // How far fixtures of a body may reach past its strip
+    float reach;
+    std::size_t migrations;
+    std::uint32_t sync_frame;
+
+    // Create, move and destroy ghosts, so they match bodies within reach of
+    // strips' edges
+    void sync_ghosts();
+    void mirror(b2Body* source, Shard& target);
+    void remove_ghost(Shard& shard, entt::entity entity);
+    void find_leaving(Shard& shard);
+    // Recreate body in target world and destroy the original one
+    void migrate(b2Body* body, Shard& target);
+};
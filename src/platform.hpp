@@ -11,6 +11,9 @@ public:
     virtual std::string get_sprites_dir() = 0;
     virtual std::string get_sounds_dir() = 0;
     virtual std::string get_settings_dir() = 0;
+    // CPU time consumed by the whole process (all threads, user and kernel
+    // modes) since its start, in seconds
+    virtual double get_cpu_time() = 0;
 
     virtual ~Platform() = default;
 };
@@ -0,0 +1,301 @@
+#include "profiler.hpp"
+
+#include "alloc_tracker.hpp"
+#include "app.hpp"
+#include "latency.hpp"
+
+#include <fmt/format.h>
+
+#include <raylib.h>
+
+#include <algorithm>
+
+static constexpr const char* SECTION_NAMES[Profiler::SECTIONS] = {
+    "physics",
+    "sim lod",
+    "wind",
+    "spawn",
+    "mouse",
+    "chain",
+    "events",
+    "particles",
+    "draw walls",
+    "draw balls",
+    "hud",
+    "ui",
+};
+
+// Frame time that is drawn as full-height bar on graph, in ms
+static constexpr float GRAPH_CEILING = 33.3f;
+static constexpr float GRAPH_HEIGHT = 60.0f;
+static constexpr float BUDGET_MS = 1000.0f / 60.0f;
+static constexpr int FONT_SIZE = 10;
+static constexpr int LINE_HEIGHT = 12;
+
+Profiler::Profiler()
+    : enabled(false)
+    , current()
+    , history()
+    , frame_times()
+    , head(0)
+    , filled(0) {}
+
+Profiler& Profiler::get() {
+    static Profiler instance;
+    return instance;
+}
+
+bool Profiler::is_enabled() const {
+    return enabled;
+}
+
+void Profiler::set_enabled(bool value) {
+    enabled = value;
+}
+
+void Profiler::add_sample(ProfSection section, float ms) {
+    current[static_cast<std::size_t>(section)] += ms;
+}
+
+void Profiler::end_frame(float frame_ms) {
+    if (!enabled) {
+        return;
+    }
+
+    history[head] = current;
+    frame_times[head] = frame_ms;
+    current.fill(0.0f);
+
+    head = (head + 1) % HISTORY;
+    filled = std::min(filled + 1, HISTORY);
+}
+
+Profiler::SectionStats Profiler::get_stats(ProfSection section) const {
+    const auto idx = static_cast<std::size_t>(section);
+    SectionStats stats = {0.0f, 0.0f};
+    if (filled == 0) {
+        return stats;
+    }
+
+    for (std::size_t i = 0; i < filled; i++) {
+        stats.average += history[i][idx];
+        stats.spike = std::max(stats.spike, history[i][idx]);
+    }
+    stats.average /= filled;
+
+    return stats;
+}
+
+Profiler::SectionStats Profiler::get_frame_stats() const {
+    SectionStats stats = {0.0f, 0.0f};
+    if (filled == 0) {
+        return stats;
+    }
+
+    for (std::size_t i = 0; i < filled; i++) {
+        stats.average += frame_times[i];
+        stats.spike = std::max(stats.spike, frame_times[i]);
+    }
+    stats.average /= filled;
+
+    return stats;
+}
+
+float Profiler::get_frame_time(std::size_t age) const {
+    if (age >= filled) {
+        return 0.0f;
+    }
+
+    return frame_times[(head + HISTORY - 1 - age) % HISTORY];
+}
+
+const char* Profiler::get_name(ProfSection section) {
+    return SECTION_NAMES[static_cast<std::size_t>(section)];
+}
+
+ScopedTimer::ScopedTimer(ProfSection section)
+    : section(section)
+    , active(Profiler::get().is_enabled()) {
+    if (active) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (active) {
+        const std::chrono::duration<float, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        Profiler::get().add_sample(section, elapsed.count());
+    }
+}
+
+ProfilerOverlay::ProfilerOverlay(Vector2 pos, const App* app)
+    : pos(pos)
+    , visible(true)
+    , app(app) {}
+
+void ProfilerOverlay::update(float) {
+    if (IsKeyPressed(KEY_F3)) {
+        visible = !visible;
+    }
+}
+
+void ProfilerOverlay::draw() {
+    if (!visible) {
+        return;
+    }
+
+    const auto& prof = Profiler::get();
+    const float width = Profiler::HISTORY;
+    const auto latency = InputLatency::get().get_stats();
+    const std::size_t lines = Profiler::SECTIONS + 6 + (AllocTracker::is_enabled() ? 1 : 0) +
+                              (latency.samples > 0 ? 1 : 0);
+    const float height = lines * LINE_HEIGHT + GRAPH_HEIGHT + 8.0f;
+    const int x = static_cast<int>(pos.x);
+    int y = static_cast<int>(pos.y);
+
+    DrawRectangle(x, y, static_cast<int>(width), static_cast<int>(height), Fade(BLACK, 0.6f));
+
+    const auto frame = prof.get_frame_stats();
+    DrawText(
+        fmt::format("frame  avg {:.2f} ms  max {:.2f} ms", frame.average, frame.spike)
+            .c_str(),
+        x + 4,
+        y + 4,
+        FONT_SIZE,
+        WHITE);
+    y += LINE_HEIGHT + 4;
+
+    const auto pacing = app->pacer.get_stats();
+    DrawText(
+        fmt::format(
+            "pacing {} {:.1f} ms  jitter {:.3f} ms  worst {:.2f} ms",
+            get_pacing_mode_name(app->pacer.get_mode()),
+            pacing.target,
+            pacing.jitter,
+            pacing.worst)
+            .c_str(),
+        x + 4,
+        y,
+        FONT_SIZE,
+        pacing.jitter > 1.0f ? ORANGE : LIGHTGRAY);
+    y += LINE_HEIGHT;
+
+    const auto state = app->governor->get_state();
+    DrawText(
+        fmt::format(
+            "power  {}  cpu {:.1f}%  (active {:.1f}%)",
+            IdleGovernor::get_name(state),
+            app->governor->get_cpu_usage(state),
+            app->governor->get_cpu_usage(IdleState::active))
+            .c_str(),
+        x + 4,
+        y,
+        FONT_SIZE,
+        LIGHTGRAY);
+    y += LINE_HEIGHT;
+
+    const auto& quality = app->quality;
+    DrawText(
+        fmt::format(
+            "quality {}/{} ({})  work {:.2f} ms  physics {:.2f} ms",
+            quality.get_level(),
+            quality.get_max_level(),
+            quality.get_description(),
+            quality.get_average_work(),
+            quality.get_average_physics())
+            .c_str(),
+        x + 4,
+        y,
+        FONT_SIZE,
+        quality.get_level() > 0 ? ORANGE : LIGHTGRAY);
+    y += LINE_HEIGHT;
+
+    const auto& jobs = *app->jobs;
+    float busiest = 0.0f;
+    float total = 0.0f;
+    for (std::size_t i = 0; i < jobs.get_workers_amount(); i++) {
+        const float utilization = jobs.get_stats(i).utilization;
+        busiest = std::max(busiest, utilization);
+        total += utilization;
+    }
+    DrawText(
+        fmt::format(
+            "jobs   {} workers  avg {:.1f}%  busiest {:.1f}%",
+            jobs.get_workers_amount(),
+            jobs.get_workers_amount() > 0 ? total / jobs.get_workers_amount() * 100.0f
+                                          : 0.0f,
+            busiest * 100.0f)
+            .c_str(),
+        x + 4,
+        y,
+        FONT_SIZE,
+        LIGHTGRAY);
+    y += LINE_HEIGHT;
+
+    for (std::size_t i = 0; i < Profiler::SECTIONS; i++) {
+        const auto section = static_cast<ProfSection>(i);
+        const auto stats = prof.get_stats(section);
+        DrawText(
+            fmt::format(
+                "{:<10} avg {:.3f} ms  max {:.3f} ms",
+                Profiler::get_name(section),
+                stats.average,
+                stats.spike)
+                .c_str(),
+            x + 4,
+            y,
+            FONT_SIZE,
+            stats.spike > BUDGET_MS / 2 ? ORANGE : LIGHTGRAY);
+        y += LINE_HEIGHT;
+    }
+
+    if (AllocTracker::is_enabled()) {
+        const auto allocs = AllocTracker::get_last_frame();
+        DrawText(
+            fmt::format(
+                "allocs {}/frame  {:.1f} KiB/frame  live {:.1f} KiB",
+                allocs.allocs,
+                allocs.bytes / 1024.0f,
+                allocs.live_bytes / 1024.0f)
+                .c_str(),
+            x + 4,
+            y,
+            FONT_SIZE,
+            allocs.allocs > 0 ? ORANGE : LIGHTGRAY);
+        y += LINE_HEIGHT;
+    }
+
+    if (latency.samples > 0) {
+        DrawText(
+            fmt::format(
+                "input  p50 {:.1f} ms  p95 {:.1f} ms  max {:.1f} ms",
+                latency.p50,
+                latency.p95,
+                latency.max)
+                .c_str(),
+            x + 4,
+            y,
+            FONT_SIZE,
+            latency.p95 > BUDGET_MS * 2 ? ORANGE : LIGHTGRAY);
+        y += LINE_HEIGHT;
+    }
+
+    // Frame time graph, newest frame on the right
+    const int graph_bottom = y + LINE_HEIGHT + static_cast<int>(GRAPH_HEIGHT);
+    for (std::size_t age = 0; age < Profiler::HISTORY; age++) {
+        const float ms = prof.get_frame_time(age);
+        const float bar = std::min(ms / GRAPH_CEILING, 1.0f) * GRAPH_HEIGHT;
+        const int bar_x = x + static_cast<int>(width) - 1 - static_cast<int>(age);
+        DrawLine(
+            bar_x,
+            graph_bottom,
+            bar_x,
+            graph_bottom - static_cast<int>(bar),
+            ms > BUDGET_MS ? RED : GREEN);
+    }
+
+    const int budget_y =
+        graph_bottom - static_cast<int>(BUDGET_MS / GRAPH_CEILING * GRAPH_HEIGHT);
+    DrawLine(x, budget_y, x + static_cast<int>(width), budget_y, YELLOW);
+}
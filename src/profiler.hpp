@@ -0,0 +1,112 @@
+#pragma once
+
+#include <engine/core.hpp>
+
+#include <raylib.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+class App;
+
+// Subsystems that are being timed. Adding new one requires adding its name
+// into profiler.cpp too.
+enum class ProfSection : std::uint8_t {
+    physics,
+    sim_lod,
+    wind,
+    spawn,
+    mouse,
+    chain,
+    events,
+    particles,
+    draw_walls,
+    draw_balls,
+    hud,
+    ui,
+    count
+};
+
+// Collects per-section timings of last HISTORY frames into a ring buffer.
+// There is just one instance of it, since timers may be placed anywhere.
+class Profiler {
+public:
+    static constexpr std::size_t HISTORY = 240;
+    static constexpr std::size_t SECTIONS = static_cast<std::size_t>(ProfSection::count);
+
+    struct SectionStats {
+        // Both are in milliseconds
+        float average;
+        float spike;
+    };
+
+    static Profiler& get();
+
+    bool is_enabled() const;
+    void set_enabled(bool value);
+
+    // Add time spent in section during current frame
+    void add_sample(ProfSection section, float ms);
+    // Commit current frame into history. Must be called once per frame.
+    void end_frame(float frame_ms);
+
+    SectionStats get_stats(ProfSection section) const;
+    SectionStats get_frame_stats() const;
+    // Frame time (in ms) of frame that has been committed `age` frames ago
+    float get_frame_time(std::size_t age) const;
+
+    static const char* get_name(ProfSection section);
+
+private:
+    Profiler();
+
+    bool enabled;
+
+    std::array<float, SECTIONS> current;
+    std::array<std::array<float, SECTIONS>, HISTORY> history;
+    std::array<float, HISTORY> frame_times;
+    // Position in history the next frame will be written to
+    std::size_t head;
+    // Amount of frames that have been written, up to HISTORY
+    std::size_t filled;
+};
+
+// Adds time between its construction and destruction to specified section
+class ScopedTimer {
+private:
+    ProfSection section;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    ScopedTimer(ProfSection section);
+    ~ScopedTimer();
+};
+
+// Timers are only compiled in if GAME_PROFILER is defined. Without it, these
+// compile down to nothing, so markers may be left in hot paths.
+#if defined(GAME_PROFILER)
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(section) ScopedTimer PROFILER_CONCAT(profile_scope_, __LINE__)(section)
+#else
+#define PROFILE_SCOPE(section) ((void)0)
+#endif
+
+// Overlay with per-section averages, spikes and frame time graph.
+// Can be hidden with F3 without disabling profiler.
+class ProfilerOverlay : public Node {
+private:
+    Vector2 pos;
+    bool visible;
+    // Pacing, power and quality stats are shown too
+    const App* app;
+
+public:
+    ProfilerOverlay(Vector2 pos, const App* app);
+
+    void update(float dt) override;
+    void draw() override;
+};
@@ -0,0 +1,190 @@
+#include "quality.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+
+struct QualityStep {
+    const char* description;
+    // Applied to base settings. Iterations, physics rate and spawn cap are
+    // scaled, circle segments are capped and particle budget is multiplied.
+    float iterations;
+    float physics_rate;
+    int circle_segments;
+    float particle_budget;
+    float max_enemies;
+};
+
+// Each step only changes one knob compared to the previous one
+static constexpr QualityStep STEPS[] = {
+    {"full quality", 1.0f, 1.0f, 36, 1.0f, 1.0f},
+    {"fewer solver iterations", 0.67f, 1.0f, 36, 1.0f, 1.0f},
+    {"minimal solver iterations", 0.5f, 1.0f, 36, 1.0f, 1.0f},
+    {"physics at 3/4 rate", 0.5f, 0.75f, 36, 1.0f, 1.0f},
+    {"physics at half rate", 0.5f, 0.5f, 36, 1.0f, 1.0f},
+    {"coarser circles", 0.5f, 0.5f, 20, 1.0f, 1.0f},
+    {"coarsest circles", 0.5f, 0.5f, 12, 1.0f, 1.0f},
+    {"half of particles", 0.5f, 0.5f, 12, 0.5f, 1.0f},
+    {"quarter of particles", 0.5f, 0.5f, 12, 0.25f, 1.0f},
+    {"lower spawn cap", 0.5f, 0.5f, 12, 0.25f, 0.67f},
+    {"lowest spawn cap", 0.5f, 0.5f, 12, 0.25f, 0.4f},
+};
+static constexpr std::size_t STEPS_AMOUNT = sizeof(STEPS) / sizeof(STEPS[0]);
+
+// Frames averaged per evaluation
+static constexpr int WINDOW = 30;
+// Quality is lowered if frames take more than that part of budget, or physics
+// alone takes more than PHYSICS_SHARE of it
+static constexpr float DEGRADE_AT = 0.9f;
+static constexpr float PHYSICS_SHARE = 0.5f;
+// And restored once frames take less than that
+static constexpr float RESTORE_AT = 0.6f;
+// Consecutive windows required to lower or restore quality. Restoring is
+// slower, so short spikes of headroom don't cause oscillation.
+static constexpr int DEGRADE_WINDOWS = 2;
+static constexpr int RESTORE_WINDOWS = 4;
+// If restored step didn't hold, the next restore requires longer headroom
+static constexpr int MAX_RESTORE_WINDOWS = 32;
+static constexpr int COOLDOWN_WINDOWS = 2;
+
+QualityGovernor::QualityGovernor()
+    : enabled(true)
+    , level(0)
+    , work_sum(0.0f)
+    , physics_sum(0.0f)
+    , frames(0)
+    , average_work(0.0f)
+    , average_physics(0.0f)
+    , over_budget(0)
+    , under_budget(0)
+    , cooldown(0)
+    , restore_windows(RESTORE_WINDOWS)
+    , last_restored(false) {}
+
+void QualityGovernor::set_enabled(bool value) {
+    enabled = value;
+    if (!enabled && level != 0) {
+        spdlog::info("Adaptive quality disabled, restoring full quality");
+        set_level(0);
+    }
+}
+
+bool QualityGovernor::is_enabled() const {
+    return enabled;
+}
+
+void QualityGovernor::set_level(std::size_t new_level) {
+    level = new_level;
+    over_budget = 0;
+    under_budget = 0;
+    cooldown = COOLDOWN_WINDOWS;
+}
+
+void QualityGovernor::update(float work_ms, float physics_ms, float budget_ms) {
+    if (!enabled) {
+        return;
+    }
+
+    work_sum += work_ms;
+    physics_sum += physics_ms;
+    frames++;
+    if (frames < WINDOW) {
+        return;
+    }
+
+    average_work = work_sum / frames;
+    average_physics = physics_sum / frames;
+    work_sum = 0.0f;
+    physics_sum = 0.0f;
+    frames = 0;
+
+    if (cooldown > 0) {
+        cooldown--;
+        return;
+    }
+
+    const bool over =
+        average_work > budget_ms * DEGRADE_AT || average_physics > budget_ms * PHYSICS_SHARE;
+    const bool under = average_work < budget_ms * RESTORE_AT;
+
+    if (over) {
+        under_budget = 0;
+        over_budget++;
+    }
+    else if (under) {
+        over_budget = 0;
+        under_budget++;
+    }
+    else {
+        over_budget = 0;
+        under_budget = 0;
+    }
+
+    if (over_budget >= DEGRADE_WINDOWS && level + 1 < STEPS_AMOUNT) {
+        if (last_restored) {
+            restore_windows = std::min(restore_windows * 2, MAX_RESTORE_WINDOWS);
+        }
+        last_restored = false;
+
+        set_level(level + 1);
+        spdlog::warn(
+            "Frames take {:.2f} ms (physics {:.2f} ms) of {:.2f} ms budget, lowering "
+            "quality to level {}: {}",
+            average_work,
+            average_physics,
+            budget_ms,
+            level,
+            STEPS[level].description);
+    }
+    else if (under_budget >= restore_windows && level > 0) {
+        if (last_restored) {
+            restore_windows = RESTORE_WINDOWS;
+        }
+        last_restored = true;
+
+        spdlog::info(
+            "Frames take {:.2f} ms of {:.2f} ms budget, restoring quality from level {}: "
+            "no more {}",
+            average_work,
+            budget_ms,
+            level,
+            STEPS[level].description);
+        set_level(level - 1);
+    }
+}
+
+static int scale(int value, float factor) {
+    return std::max(static_cast<int>(std::lround(static_cast<float>(value) * factor)), 1);
+}
+
+QualitySettings QualityGovernor::apply(const QualitySettings& base) const {
+    const auto& step = STEPS[level];
+    return {
+        scale(base.velocity_iterations, step.iterations),
+        scale(base.position_iterations, step.iterations),
+        base.physics_rate * step.physics_rate,
+        std::min(base.circle_segments, step.circle_segments),
+        base.particle_budget * step.particle_budget,
+        scale(base.max_enemies, step.max_enemies)};
+}
+
+std::size_t QualityGovernor::get_level() const {
+    return level;
+}
+
+std::size_t QualityGovernor::get_max_level() const {
+    return STEPS_AMOUNT - 1;
+}
+
+const char* QualityGovernor::get_description() const {
+    return STEPS[level].description;
+}
+
+float QualityGovernor::get_average_work() const {
+    return average_work;
+}
+
+float QualityGovernor::get_average_physics() const {
+    return average_physics;
+}
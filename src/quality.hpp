@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+
+// Knobs that trade visual or simulation quality for frame time
+struct QualitySettings {
+    int velocity_iterations;
+    int position_iterations;
+    // Physics steps per second
+    float physics_rate;
+    // Segments per circle when drawing balls
+    int circle_segments;
+    // Share of particle pool that may be used, 0-1
+    float particle_budget;
+    // Balls are only spawned while there are less than that many on screen
+    int max_enemies;
+};
+
+// Lowers quality when frames don't fit into the budget and restores it once
+// there is enough headroom again. Steps are taken one at a time, in fixed
+// order: solver iterations, physics rate, circle tessellation, particles and,
+// as the last resort, spawn cap. Restoring goes in reverse order.
+class QualityGovernor {
+public:
+    QualityGovernor();
+
+    void set_enabled(bool value);
+    bool is_enabled() const;
+
+    // Must be called once per simulated frame. work_ms is time the frame took
+    // without waiting for vsync or frame limiter, physics_ms is part of it
+    // spent on physics steps.
+    void update(float work_ms, float physics_ms, float budget_ms);
+
+    // Lower base settings (e.g the ones from settings.toml) to current level
+    QualitySettings apply(const QualitySettings& base) const;
+    // 0 is full quality, the higher the worse
+    std::size_t get_level() const;
+    std::size_t get_max_level() const;
+    // What has been lowered to reach current level
+    const char* get_description() const;
+    // Averages of the last evaluation window, in ms
+    float get_average_work() const;
+    float get_average_physics() const;
+
+private:
+    bool enabled;
+    std::size_t level;
+
+    float work_sum;
+    float physics_sum;
+    int frames;
+    float average_work;
+    float average_physics;
+
+    // Consecutive windows that were over budget or had enough headroom
+    int over_budget;
+    int under_budget;
+    // Windows to skip after a change, so its effect gets measured first
+    int cooldown;
+    // Grows each time restored level turns out to be too slow
+    int restore_windows;
+    bool last_restored;
+
+    void set_level(std::size_t new_level);
+};
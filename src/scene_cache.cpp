@@ -0,0 +1,148 @@
+#include "scene_cache.hpp"
+
+#include "alloc_tracker.hpp"
+#include "level.hpp"
+#include "menus.hpp"
+#include "trace.hpp"
+
+#include <spdlog/spdlog.h>
+
+// Frames main menu should be shown for before starting to build the next level
+static constexpr int PREWARM_DELAY = 2;
+
+CachedScene::CachedScene(Scene* scene)
+    : scene(scene) {}
+
+void CachedScene::update(float dt) {
+    scene->update(dt);
+}
+
+void CachedScene::draw() {
+    scene->draw();
+}
+
+SceneCache::SceneCache(App* app, SceneManager* mgr)
+    : app(app)
+    , mgr(mgr)
+    , current(nullptr)
+    , current_reporter(nullptr)
+    , current_name("none")
+    , settling(false)
+    , menu_frames(0) {}
+
+// Defined here, since scene types are incomplete in header
+SceneCache::~SceneCache() = default;
+
+void SceneCache::switch_to(
+    const char* name, Scene* scene, std::unique_ptr<Scene> owned) {
+    TRACE_SCOPE("set_current_scene");
+
+    if (running != nullptr) {
+        retired.push_back(std::move(running));
+    }
+    running = std::move(owned);
+
+    current = scene;
+    current_reporter = dynamic_cast<const IdleReporter*>(scene);
+    current_name = name;
+    settling = true;
+    menu_frames = 0;
+    mgr->set_current_scene(new CachedScene(scene));
+}
+
+void SceneCache::open_title_screen() {
+    TRACE_SCOPE("open title screen");
+    auto title = std::make_unique<TitleScreen>(app);
+    Scene* ptr = title.get();
+    switch_to("TitleScreen", ptr, std::move(title));
+}
+
+void SceneCache::open_main_menu() {
+    TRACE_SCOPE("open main menu");
+    if (main_menu == nullptr) {
+        main_menu = std::make_unique<MainMenu>(app);
+    }
+    else {
+        main_menu->reset();
+    }
+
+    switch_to("MainMenu", main_menu.get());
+}
+
+void SceneCache::open_settings() {
+    TRACE_SCOPE("open settings");
+    if (settings == nullptr) {
+        settings = std::make_unique<SettingsScreen>(app);
+    }
+
+    switch_to("SettingsScreen", settings.get());
+}
+
+void SceneCache::start_level() {
+    TRACE_SCOPE("start level");
+    if (next_level == nullptr) {
+        spdlog::debug("Level has not been pre-built, building it now");
+        prewarm_level();
+    }
+
+    Scene* ptr = next_level.get();
+    switch_to("Level", ptr, std::move(next_level));
+}
+
+void SceneCache::prewarm_level() {
+    if (next_level != nullptr) {
+        return;
+    }
+
+    TRACE_SCOPE("build level");
+    next_level = std::make_unique<Level>(app);
+}
+
+void SceneCache::discard_settings() {
+    if (settings == nullptr) {
+        return;
+    }
+
+    if (current == settings.get()) {
+        retired.push_back(std::move(settings));
+    }
+    else {
+        settings.reset();
+    }
+}
+
+void SceneCache::invalidate() {
+    spdlog::debug("Invalidating scene cache");
+    // Any of these may be the one currently running and requesting invalidation
+    retired.push_back(std::move(main_menu));
+    retired.push_back(std::move(settings));
+    retired.push_back(std::move(next_level));
+}
+
+void SceneCache::update() {
+    if (!retired.empty()) {
+        TRACE_SCOPE("destroy retired scenes");
+        retired.clear();
+    }
+
+    if (settling) {
+        settling = false;
+        AllocTracker::on_scene_settled(current_name);
+    }
+
+    if (main_menu != nullptr && current == main_menu.get() && next_level == nullptr) {
+        menu_frames++;
+        if (menu_frames > PREWARM_DELAY) {
+            spdlog::debug("Pre-building next level");
+            prewarm_level();
+        }
+    }
+}
+
+Scene* SceneCache::get_current() {
+    return current;
+}
+
+bool SceneCache::is_current_idle() const {
+    return current_reporter != nullptr && current_reporter->is_idle();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "idle.hpp"
+
+#include <engine/core.hpp>
+
+#include <memory>
+#include <vector>
+
+class App;
+class Level;
+class MainMenu;
+class SettingsScreen;
+
+// Non-owning wrapper around scene. SceneManager deletes previous scene on each
+// transition, thus scenes that must outlive it are handed over wrapped into this.
+class CachedScene : public Scene {
+private:
+    Scene* scene;
+
+public:
+    CachedScene(Scene* scene);
+
+    void update(float dt) override;
+    void draw() override;
+};
+
+// Owner of all scenes. Long-lived screens (main menu, settings) are built once
+// and reused, and next Level is built ahead of time while main menu is idle,
+// so starting a new game is just a pointer swap.
+class SceneCache {
+private:
+    App* app;
+    SceneManager* mgr;
+
+    std::unique_ptr<MainMenu> main_menu;
+    std::unique_ptr<SettingsScreen> settings;
+    std::unique_ptr<Level> next_level;
+
+    // Scene that is not cached, but is currently running (title screen, level)
+    std::unique_ptr<Scene> running;
+    Scene* current;
+    // Same scene, if it is able to tell when it's idle
+    const IdleReporter* current_reporter;
+    const char* current_name;
+    // Set on transition, reset once previous scene has been destroyed
+    bool settling;
+
+    // Scenes that have been switched away from. Transitions are requested from
+    // within Scene::update(), thus these can't be destroyed right away.
+    std::vector<std::unique_ptr<Scene>> retired;
+
+    // Amount of frames main menu has been shown for. Level is pre-built only
+    // after menu has been drawn at least once, to not delay its appearance.
+    int menu_frames;
+
+    void switch_to(const char* name, Scene* scene, std::unique_ptr<Scene> owned = nullptr);
+
+public:
+    SceneCache(App* app, SceneManager* mgr);
+    ~SceneCache();
+
+    void open_title_screen();
+    void open_main_menu();
+    void open_settings();
+    void start_level();
+
+    // Build next Level in advance. No-op if it has already been built.
+    void prewarm_level();
+
+    // Throw away cached settings screen, e.g if it has unsaved changes.
+    void discard_settings();
+    // Throw away all cached scenes. Must be called on window resize, since
+    // scenes are laid out based on window size. Must be followed by transition
+    // to some scene, since current one may get destroyed on next update().
+    void invalidate();
+
+    // Must be called once per frame. Destroys retired scenes and pre-builds
+    // next level when main menu is shown.
+    void update();
+
+    Scene* get_current();
+    // True if current scene reports that it has nothing to animate
+    bool is_current_idle() const;
+};
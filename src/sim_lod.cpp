@@ -0,0 +1,262 @@
+#include "sim_lod.hpp"
+
+#include "components.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+
+// Distances to other bodies, in world units. Same hysteresis as with margins:
+// balloons must get closer than PROMOTE_CLEARANCE to wake up, but further than
+// DEMOTE_CLEARANCE to fall asleep.
+static constexpr float PROMOTE_CLEARANCE = 20.0f;
+static constexpr float DEMOTE_CLEARANCE = 40.0f;
+// The most dormant balloon may move per update. Clearance is checked after
+// each move, so a smaller step can't carry balloon into a wall (or, with two
+// dormant balloons approaching each other, into one another) unnoticed. Only
+// matters on long frames, e.g at 5 fps in background.
+static constexpr float MAX_DORMANT_STEP = PROMOTE_CLEARANCE / 2.0f;
+// Demotion walks every simulated balloon, thus is done once per that many
+// updates only. Balloons going dormant a bit later cost nothing but a few steps.
+static constexpr std::size_t DEMOTE_INTERVAL = 8;
+
+// Whether circle's edge is within margin of rectangle (or inside of it)
+static bool is_near_view(Rectangle view, b2Vec2 center, float radius, float margin) {
+    const float dx =
+        std::max({view.x - center.x, 0.0f, center.x - view.x - view.width});
+    const float dy =
+        std::max({view.y - center.y, 0.0f, center.y - view.y - view.height});
+    const float reach = radius + margin;
+    return dx * dx + dy * dy <= reach * reach;
+}
+
+// Whether b (grown by margin on each side) covers all of a
+static bool covers(Rectangle b, Rectangle a, float margin) {
+    return b.x - margin <= a.x && b.y - margin <= a.y
+        && a.x + a.width <= b.x + b.width + margin
+        && a.y + a.height <= b.y + b.height + margin;
+}
+
+SimulationLod::SimulationLod(entt::registry& registry, const PhysicsShards& shards)
+    : registry(registry)
+    , shards(shards)
+    , enabled(true)
+    , promote_margin(0.0f)
+    , demote_margin(0.0f)
+    , room()
+    , has_room(false)
+    , updates(0)
+    , stats()
+    , query_body(nullptr)
+    , query_found(false) {}
+
+void SimulationLod::set_enabled(bool enabled) {
+    this->enabled = enabled;
+    if (enabled) {
+        return;
+    }
+
+    auto view = registry.view<PhysicsBodyComponent, DormantComponent>();
+    dormant.clear();
+    view.each([this](auto entity, auto& phys) {
+        dormant.push_back({entity, phys.body, 0.0f, 0.0f, true});
+    });
+    for (const auto& ball : dormant) {
+        promote(ball.entity, ball.body);
+    }
+    dormant.clear();
+    stats.dormant = 0;
+}
+
+bool SimulationLod::is_enabled() const {
+    return enabled;
+}
+
+void SimulationLod::set_margins(float promote, float demote) {
+    promote_margin = promote;
+    demote_margin = std::max(promote, demote);
+}
+
+void SimulationLod::set_room(Rectangle room) {
+    this->room = room;
+    has_room = true;
+}
+
+void SimulationLod::integrate(float elapsed, float step_time) {
+    auto view = registry.view<BallComponent, PhysicsBodyComponent, DormantComponent>();
+
+    // Box2d clamps translation per step, so the same is done here, else
+    // balloons would speed up while nobody looks at them
+    const float max_speed = b2_maxTranslation / step_time;
+    const b2Vec2 gravity = shards.get_gravity();
+
+    dormant.clear();
+    view.each([&](auto entity, auto& ball, auto& phys) {
+        b2Body* body = phys.body;
+        dormant.push_back({entity, body, ball.radius, 0.0f, false});
+
+        if (elapsed <= 0.0f) {
+            return;
+        }
+
+        // Constant acceleration, thus the average of start and end velocities
+        // gives the exact displacement. Balloons have no damping.
+        const b2Vec2 v0 = body->GetLinearVelocity();
+        b2Vec2 v1 = v0 + elapsed * (body->GetGravityScale() * gravity);
+        const float speed = v1.Length();
+        if (speed > max_speed) {
+            v1 *= max_speed / speed;
+        }
+
+        b2Vec2 step = (0.5f * elapsed) * (v0 + v1);
+        const float distance = step.Length();
+        if (distance > MAX_DORMANT_STEP) {
+            step *= MAX_DORMANT_STEP / distance;
+        }
+
+        body->SetLinearVelocity(v1);
+        body->SetTransform(
+            body->GetPosition() + step,
+            body->GetAngle() + elapsed * body->GetAngularVelocity());
+    });
+}
+
+void SimulationLod::find_promotions(Rectangle view) {
+    for (auto& ball : dormant) {
+        ball.min_x = ball.body->GetPosition().x - ball.radius;
+        ball.promote = is_near_view(
+            view, ball.body->GetPosition(), ball.radius, promote_margin);
+    }
+
+    // Dormant balloons aren't in broadphase, thus can't find each other with
+    // queries. Sweeping along x instead.
+    std::sort(dormant.begin(), dormant.end(), [](const Dormant& a, const Dormant& b) {
+        return a.min_x < b.min_x;
+    });
+    for (std::size_t i = 0; i < dormant.size(); i++) {
+        auto& a = dormant[i];
+        const b2Vec2 a_pos = a.body->GetPosition();
+        const float max_x = a_pos.x + a.radius + PROMOTE_CLEARANCE;
+
+        for (std::size_t j = i + 1; j < dormant.size(); j++) {
+            auto& b = dormant[j];
+            // Everything further is out of reach too
+            if (b.min_x > max_x) {
+                break;
+            }
+            const float reach = a.radius + b.radius + PROMOTE_CLEARANCE;
+            if ((b.body->GetPosition() - a_pos).LengthSquared() <= reach * reach) {
+                a.promote = true;
+                b.promote = true;
+            }
+        }
+    }
+
+    for (auto& ball : dormant) {
+        if (!ball.promote) {
+            ball.promote = has_neighbours(ball.body, ball.radius, PROMOTE_CLEARANCE);
+        }
+    }
+}
+
+void SimulationLod::demote(Rectangle view) {
+    auto balls = registry.view<BallComponent, PhysicsBodyComponent>(
+        entt::exclude<DormantComponent>);
+
+    // Collected first, since registry can't be changed while it's iterated
+    candidates.clear();
+    balls.each([&](auto entity, auto& ball, auto& phys) {
+        b2Body* body = phys.body;
+        if (body->GetType() != b2_dynamicBody
+            || is_near_view(view, body->GetPosition(), ball.radius, demote_margin)
+            // Contacts exist as soon as fat AABBs overlap, so this is the
+            // cheapest "something is nearby" check there is
+            || body->GetContactList() != nullptr
+            || has_neighbours(body, ball.radius, DEMOTE_CLEARANCE)) {
+            return;
+        }
+        candidates.push_back({entity, body, ball.radius, 0.0f, false});
+    });
+
+    for (const auto& ball : candidates) {
+        LOG_RATE_LIMITED(
+            1.0f,
+            TRACE,
+            physics,
+            "Entity {} becomes dormant",
+            static_cast<uint32_t>(ball.entity));
+        ball.body->SetEnabled(false);
+        registry.emplace<DormantComponent>(ball.entity);
+        stats.demotions++;
+    }
+    stats.dormant += candidates.size();
+}
+
+void SimulationLod::update(Rectangle view, float elapsed, float step_time) {
+    if (!enabled) {
+        return;
+    }
+
+    integrate(elapsed, step_time);
+    find_promotions(view);
+
+    stats.dormant = 0;
+    for (const auto& ball : dormant) {
+        if (ball.promote) {
+            promote(ball.entity, ball.body);
+        }
+        else {
+            stats.dormant++;
+        }
+    }
+
+    // With the whole room in view (the usual case with default room size)
+    // nothing may become dormant, so there is no point in looking
+    if (has_room && covers(view, room, demote_margin)) {
+        return;
+    }
+    if (updates++ % DEMOTE_INTERVAL == 0) {
+        demote(view);
+    }
+}
+
+const SimulationLod::Stats& SimulationLod::get_stats() const {
+    return stats;
+}
+
+void SimulationLod::promote(entt::entity entity, b2Body* body) {
+    LOG_RATE_LIMITED(
+        1.0f, TRACE, physics, "Entity {} wakes up", static_cast<uint32_t>(entity));
+    // Proxies are created right away, contacts are found on the next step
+    body->SetEnabled(true);
+    registry.remove<DormantComponent>(entity);
+    stats.promotions++;
+}
+
+bool SimulationLod::has_neighbours(b2Body* body, float radius, float distance) {
+    const float extent = radius + distance;
+    const b2Vec2 pos = body->GetPosition();
+
+    b2AABB area;
+    area.lowerBound = {pos.x - extent, pos.y - extent};
+    area.upperBound = {pos.x + extent, pos.y + extent};
+
+    query_body = body;
+    query_found = false;
+    shards.for_each_world_in(
+        area.lowerBound.x, area.upperBound.x, [this, &area](const b2World& world) {
+            if (!query_found) {
+                world.QueryAABB(this, area);
+            }
+        });
+    return query_found;
+}
+
+bool SimulationLod::ReportFixture(b2Fixture* fixture) {
+    // Ghost's source is found in its own world
+    if (fixture->GetBody() == query_body || PhysicsShards::is_ghost(fixture->GetBody())) {
+        return true;
+    }
+    query_found = true;
+    // Any neighbour is enough
+    return false;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "physics_shards.hpp"
+
+#include <box2d/box2d.h>
+#include <entt/entt.hpp>
+#include <raylib.h>
+
+#include <cstddef>
+#include <vector>
+
+// Simulation level of detail for balloons. Box2d steps every enabled body, even
+// if nobody sees it and it touches nothing - yet most of balloons just rise and
+// drift with the wind. Such balloons (outside of the view and away from other
+// bodies) become dormant: their bodies get disabled, which takes them out of
+// broadphase, contacts and island solving, and they are moved by a closed-form
+// integrator instead. Once they approach the view or anything else, bodies are
+// enabled back and box2d takes over from the same position and velocity.
+//
+// Disabled bodies stay in the world and their transforms are kept up to date,
+// thus whatever reads positions (drawing, escape detection) works as before.
+// Wind walks the whole body list, so it keeps driving dormant balloons too.
+//
+// Only balloons outside of the view (plus margin) may go dormant, thus LOD has
+// effect in rooms larger than the window only - e.g wide sharded ones or zoomed
+// in cameras. Otherwise it notices the room is fully visible and does nothing.
+class SimulationLod : private b2QueryCallback {
+public:
+    struct Stats {
+        std::size_t dormant;
+        // Since level start
+        std::size_t promotions;
+        std::size_t demotions;
+    };
+
+    SimulationLod(entt::registry& registry, const PhysicsShards& shards);
+
+    SimulationLod(const SimulationLod&) = delete;
+    SimulationLod& operator=(const SimulationLod&) = delete;
+
+    // Disabling promotes all dormant balloons right away
+    void set_enabled(bool enabled);
+    bool is_enabled() const;
+    // Distances from the view, in world units. Balloons closer than promote
+    // margin are always simulated, and only these further than demote margin
+    // may become dormant. The gap between these prevents flip-flopping.
+    void set_margins(float promote, float demote);
+    // Area balloons may be in, in world units. Unless set, room is assumed to be
+    // always larger than the view.
+    void set_room(Rectangle room);
+
+    // Must be called right after stepping the world. Moves dormant balloons by
+    // elapsed time (which box2d has been stepped for, in steps of step_time),
+    // then promotes and demotes balloons depending on their surroundings.
+    void update(Rectangle view, float elapsed, float step_time);
+
+    const Stats& get_stats() const;
+
+private:
+    struct Dormant {
+        entt::entity entity;
+        b2Body* body;
+        float radius;
+        // Left edge, sort key for sweep
+        float min_x;
+        bool promote;
+    };
+
+    entt::registry& registry;
+    const PhysicsShards& shards;
+
+    bool enabled;
+    float promote_margin;
+    float demote_margin;
+    Rectangle room;
+    bool has_room;
+    // Counts updates, for throttling demotion
+    std::size_t updates;
+    Stats stats;
+
+    // Reused between updates, thus these don't allocate once grown
+    std::vector<Dormant> dormant;
+    std::vector<Dormant> candidates;
+
+    // State of the running proximity query
+    b2Body* query_body;
+    bool query_found;
+
+    void integrate(float elapsed, float step_time);
+    // Mark dormant balloons that got close to the view or to each other
+    void find_promotions(Rectangle view);
+    void demote(Rectangle view);
+
+    void promote(entt::entity entity, b2Body* body);
+    // Whether there are other enabled bodies within distance of the balloon
+    bool has_neighbours(b2Body* body, float radius, float distance);
+    bool ReportFixture(b2Fixture* fixture) override;
+};
@@ -0,0 +1,75 @@
+#include "slicing.hpp"
+
+#include <algorithm>
+
+// Id used for mouse, since it can't clash with ids of touch points
+static constexpr int MOUSE_POINTER_ID = -1;
+// Pointers that moved less than that are considered standing still
+static constexpr float MIN_SLICE_LENGTH = 1.0f;
+
+void SliceInput::add_sample(
+    int id,
+    Vector2 pos,
+    const std::array<Pointer, MAX_POINTERS>& previous,
+    std::size_t previous_amount) {
+    if (pointers_amount == MAX_POINTERS) {
+        return;
+    }
+    pointers[pointers_amount++] = {id, pos};
+
+    const auto end = previous.begin() + previous_amount;
+    const auto prev = std::find_if(
+        previous.begin(), end, [id](const Pointer& p) { return p.id == id; });
+
+    // Pointer has just been pressed, there is nothing to connect it to yet
+    if (prev == end) {
+        return;
+    }
+
+    const float dx = pos.x - prev->pos.x;
+    const float dy = pos.y - prev->pos.y;
+    if (dx * dx + dy * dy < MIN_SLICE_LENGTH * MIN_SLICE_LENGTH) {
+        return;
+    }
+
+    segments[segments_amount++] = {{prev->pos.x, prev->pos.y}, {pos.x, pos.y}};
+}
+
+void SliceInput::update(const Camera2D& camera) {
+    const auto previous = pointers;
+    const std::size_t previous_amount = pointers_amount;
+
+    pointers_amount = 0;
+    segments_amount = 0;
+
+    const int touches = std::min(GetTouchPointCount(), static_cast<int>(MAX_POINTERS));
+    if (touches > 0) {
+        for (int i = 0; i < touches; i++) {
+            add_sample(
+                GetTouchPointId(i),
+                GetScreenToWorld2D(GetTouchPosition(i), camera),
+                previous,
+                previous_amount);
+        }
+    }
+    else if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+        add_sample(
+            MOUSE_POINTER_ID,
+            GetScreenToWorld2D(GetMousePosition(), camera),
+            previous,
+            previous_amount);
+    }
+}
+
+void SliceInput::reset() {
+    pointers_amount = 0;
+    segments_amount = 0;
+}
+
+const HitTester::Segment* SliceInput::get_segments() const {
+    return segments.data();
+}
+
+std::size_t SliceInput::get_segments_amount() const {
+    return segments_amount;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "hit_test.hpp"
+
+#include <raylib.h>
+
+#include <array>
+#include <cstddef>
+
+// Turns movement of held pointers (mouse or touches) into line segments for
+// swept hit-tests. Raylib only exposes pointer positions once per frame, thus
+// each segment connects pointer's position on previous frame with its current
+// one - so even if pointer has crossed the whole screen between two frames,
+// everything on its way is covered.
+class SliceInput {
+public:
+    static constexpr std::size_t MAX_POINTERS = 10;
+
+    // Must be called once per frame. Segments are in world coordinates.
+    void update(const Camera2D& camera);
+    // Forget all pointers, so the next update starts new strokes
+    void reset();
+
+    const HitTester::Segment* get_segments() const;
+    std::size_t get_segments_amount() const;
+
+private:
+    struct Pointer {
+        int id;
+        Vector2 pos;
+    };
+
+    std::array<Pointer, MAX_POINTERS> pointers;
+    std::size_t pointers_amount = 0;
+
+    std::array<HitTester::Segment, MAX_POINTERS> segments;
+    std::size_t segments_amount = 0;
+
+    void add_sample(
+        int id,
+        Vector2 pos,
+        const std::array<Pointer, MAX_POINTERS>& previous,
+        std::size_t previous_amount);
+};
@@ -0,0 +1,123 @@
+#include "trace.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+
+static constexpr std::uint32_t UNASSIGNED_THREAD = UINT32_MAX;
+static thread_local std::uint32_t thread_id = UNASSIGNED_THREAD;
+
+Tracer::Tracer()
+    : active(false)
+    , next_thread_id(0)
+    , epoch(std::chrono::steady_clock::now()) {}
+
+Tracer& Tracer::get() {
+    static Tracer instance;
+    return instance;
+}
+
+void Tracer::start(const std::string& p) {
+    std::lock_guard<std::mutex> lock(mutex);
+    path = p;
+    epoch = std::chrono::steady_clock::now();
+    events.clear();
+    events.reserve(1024);
+    // Ensure starting thread is the first one
+    thread_id = UNASSIGNED_THREAD;
+    next_thread_id = 0;
+    active = true;
+    spdlog::info("Recording trace into {}", path);
+}
+
+bool Tracer::is_active() const {
+    return active;
+}
+
+std::uint32_t Tracer::get_thread_id() {
+    if (thread_id == UNASSIGNED_THREAD) {
+        thread_id = next_thread_id++;
+    }
+    return thread_id;
+}
+
+void Tracer::add_span(
+    const char* name,
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end) {
+    if (!active) {
+        return;
+    }
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    Event e = {
+        name,
+        duration_cast<microseconds>(start - epoch).count(),
+        duration_cast<microseconds>(end - start).count(),
+        get_thread_id()};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(e);
+}
+
+void Tracer::stop() {
+    if (!active) {
+        return;
+    }
+    active = false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        spdlog::error("Unable to write trace into {}", path);
+        return;
+    }
+
+    fmt::print(file, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fmt::print(
+        file,
+        "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+        "\"args\":{{\"name\":\"main\"}}}}");
+    for (std::uint32_t tid = 1; tid < next_thread_id; tid++) {
+        fmt::print(
+            file,
+            ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+            "\"args\":{{\"name\":\"worker {}\"}}}}",
+            tid,
+            tid);
+    }
+
+    for (const auto& e : events) {
+        fmt::print(
+            file,
+            ",\n{{\"name\":\"{}\",\"cat\":\"game\",\"ph\":\"X\",\"pid\":1,\"tid\":{},"
+            "\"ts\":{},\"dur\":{}}}",
+            e.name,
+            e.tid,
+            e.ts,
+            e.dur);
+    }
+    fmt::print(file, "\n]}}\n");
+    std::fclose(file);
+
+    spdlog::info("Written {} trace events into {}", events.size(), path);
+    events.clear();
+}
+
+TraceSpan::TraceSpan(const char* name)
+    : name(name)
+    , active(Tracer::get().is_active()) {
+    if (active) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (active) {
+        Tracer::get().add_span(name, start, std::chrono::steady_clock::now());
+    }
+}
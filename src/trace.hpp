@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Recorder of one-off expensive events (startup, asset loading, transitions),
+// written as Chrome trace-event JSON. Meant to be opened with chrome://tracing
+// or ui.perfetto.dev. Unlike Profiler, this is not meant for per-frame events.
+class Tracer {
+public:
+    static Tracer& get();
+
+    // Start recording. Events will be written into file at path on stop()
+    void start(const std::string& path);
+    // Write recorded events and stop recording
+    void stop();
+    bool is_active() const;
+
+    // Name must be a string literal (or otherwise outlive the tracer)
+    void add_span(
+        const char* name,
+        std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end);
+
+    // Small sequential id of calling thread. Main thread is the one that
+    // started the tracer and gets id 0.
+    std::uint32_t get_thread_id();
+
+private:
+    struct Event {
+        const char* name;
+        std::int64_t ts;
+        std::int64_t dur;
+        std::uint32_t tid;
+    };
+
+    Tracer();
+
+    std::atomic<bool> active;
+    std::atomic<std::uint32_t> next_thread_id;
+    std::chrono::steady_clock::time_point epoch;
+    std::string path;
+
+    std::mutex mutex;
+    std::vector<Event> events;
+};
+
+// Records span between its construction and destruction. Spans nest by time,
+// so these may be freely placed inside each other.
+class TraceSpan {
+private:
+    const char* name;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    TraceSpan(const char* name);
+    ~TraceSpan();
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
@@ -1,5 +1,21 @@
 #include "platform_windows.hpp"
 
+// Raylib is not included here, thus windows.h can't clash with it
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+
+static constexpr UINT TIMER_RESOLUTION_MS = 1;
+
+PlatformWindows::PlatformWindows() {
+    timeBeginPeriod(TIMER_RESOLUTION_MS);
+}
+
+PlatformWindows::~PlatformWindows() {
+    timeEndPeriod(TIMER_RESOLUTION_MS);
+}
+
 std::string PlatformWindows::get_resource_dir() {
     return "../Assets/";
 }
@@ -15,3 +31,20 @@ std::string PlatformWindows::get_sounds_dir() {
 std::string PlatformWindows::get_settings_dir() {
     return "./";
 }
+
+double PlatformWindows::get_cpu_time() {
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+
+    // Both are in 100 nanosecond intervals
+    const auto to_seconds = [](const FILETIME& time) {
+        ULARGE_INTEGER value;
+        value.LowPart = time.dwLowDateTime;
+        value.HighPart = time.dwHighDateTime;
+        return value.QuadPart / 1e7;
+    };
+
+    return to_seconds(kernel) + to_seconds(user);
+}
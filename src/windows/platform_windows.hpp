@@ -2,10 +2,16 @@
 
 #include "platform.hpp"
 
+// Requests 1 ms timer resolution for its lifetime. Default one is ~15.6 ms,
+// which would make every sleep of frame pacer way too late.
 class PlatformWindows : public Platform {
 public:
+    PlatformWindows();
+    ~PlatformWindows() override;
+
     std::string get_resource_dir() override;
     std::string get_sprites_dir() override;
     std::string get_sounds_dir() override;
     std::string get_settings_dir() override;
+    double get_cpu_time() override;
 };
\ No newline at end of file